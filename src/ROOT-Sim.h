@@ -68,6 +68,18 @@ typedef void (*ProcessEvent_t)(lp_id_t me, simtime_t now, unsigned event_type, c
  */
 typedef bool (*CanEnd_t)(lp_id_t me, const void *snapshot);
 
+/**
+ * @brief Determine if the memory of an idle logical process should be paged out.
+ * @param me The logical process ID of the idle LP
+ * @param idle_gvts The count of GVT phases since the LP last processed an event, at least 1
+ *
+ * @return true if the memory of the LP should be moved to the paging file, false otherwise
+ *
+ * This function is called by the thread which hosts the LP right after a GVT phase. The LP is paged back in as soon
+ * as it has to process an event.
+ */
+typedef bool (*PagingPolicy_t)(lp_id_t me, unsigned idle_gvts);
+
 enum rootsim_event {LP_INIT = 65534, LP_FINI};
 
 /**
@@ -92,6 +104,10 @@ extern void *rs_malloc(size_t req_size);
 extern void *rs_calloc(size_t nmemb, size_t size);
 extern void rs_free(void *ptr);
 extern void *rs_realloc(void *ptr, size_t req_size);
+extern void __write_mem(const void *ptr, size_t s);
+
+extern void *rs_bump_alloc(size_t req_size);
+extern void rs_bump_touch(const void *ptr, size_t size);
 
 extern double Random(void);
 extern uint64_t RandomU64(void);
@@ -206,6 +222,13 @@ extern struct topology *vInitializeTopology(enum topology_geometry geometry, int
 #define InitializeTopology(geometry, ...) vInitializeTopology(geometry, PP_NARG(__VA_ARGS__), __VA_ARGS__)
 /********* TOPOLOGY LIBRARY ************/
 
+/// The policies available to select the checkpointing interval when it is not fixed
+enum ckpt_policy {
+	CKPT_POLICY_THREAD,	//!< Use the checkpoint and silent execution costs averaged over the thread
+	CKPT_POLICY_LP,		//!< Use the checkpoint and silent execution costs profiled on each LP
+	CKPT_POLICY_MEMORY	//!< Like CKPT_POLICY_THREAD, but stretch the intervals as memory runs short
+};
+
 /// A set of configurable values used by other modules
 struct simulation_configuration {
 	/// The number of LPs to be used in the simulation
@@ -224,10 +247,41 @@ struct simulation_configuration {
 	const char *stats_file;
 	/// The checkpointing interval
 	unsigned ckpt_interval;
+	/// The policy used to select the checkpointing interval if @a ckpt_interval is zero
+	enum ckpt_policy ckpt_policy;
+	/// The memory in bytes which CKPT_POLICY_MEMORY tries not to exceed. If zero, it defaults to the physical memory
+	size_t ckpt_mem_budget;
 	/// The seed used to initialize the pseudo random numbers
 	uint64_t prng_seed;
 	/// If set, worker threads are bound to physical cores
 	bool core_binding;
+	/// If set, the model reports every write to the LP memory through __write_mem(), so that rollbacks only restore the
+	/// modified memory. This requires a build with INCREMENTAL enabled, otherwise the whole LP memory is restored
+	bool write_tracking;
+	/// If set, the LPs memory is backed by huge pages, when available, and pre-faulted by the owning worker thread
+	bool huge_pages;
+	/// The count of messages pre-allocated in a contiguous region for each thread. If zero, messages are allocated on demand
+	unsigned msg_pool_size;
+	/// If set, the message pools of each thread are enlarged at the first GVT, according to the messages needed so far
+	bool msg_pool_calibrate;
+	/// If set, the memory of the simulation is given back in bulk at the end of the run, since the process is exiting
+	bool fast_teardown;
+	/// Path to the directory hosting the files where the memory of the idle LPs is paged out. If NULL, paging is disabled
+	const char *paging_dir;
+	/// The count of GVT phases without events after which an LP is paged out. If zero, it defaults to 16
+	unsigned paging_idle_gvts;
+	/// Function pointer to the paging policy. If NULL, the LPs idle for @a paging_idle_gvts GVT phases are paged out
+	PagingPolicy_t paging_policy;
+	/// If set, the remote messages of a node are sent and received through MPI by its first worker thread only
+	bool mpi_funneled;
+	/// The count of messages each thread may send to each other node between two GVTs. If zero, there is no limit
+	unsigned remote_credit;
+	/// If not zero, one out of this many messages is sampled to profile the LP communication, saved with the statistics
+	unsigned comm_prof_period;
+	/// Path to an LP communication profile used to place the LPs. If NULL, @a placement_topology is used
+	const char *placement_profile;
+	/// The topology used to place the LPs. If NULL too, the LPs are placed by blocks of contiguous ids
+	struct topology *placement_topology;
 	/// If set, the simulation will run on the serial runtime
 	bool serial;
 	/// Function pointer to the dispatching function
@@ -11,6 +11,84 @@
  */
 #include <arch/mem.h>
 
+#include <stdint.h>
+
+/**
+ * @fn mem_region_reserve(size_t size)
+ * @brief Reserve a range of virtual addresses without backing it with memory
+ * @param size the size in bytes of the range to reserve
+ * @return a pointer to the page aligned reserved range, NULL if unsuccessful
+ *
+ * The reserved range can't be accessed until it is committed with mem_region_commit()
+ */
+
+/**
+ * @fn mem_region_commit(void *ptr, size_t size)
+ * @brief Make a part of a reserved range of virtual addresses accessible
+ * @param ptr a page aligned pointer inside a range obtained with mem_region_reserve()
+ * @param size the size in bytes of the part to commit
+ * @return 0 if successful, -1 otherwise
+ */
+
+/**
+ * @fn mem_region_release(void *ptr, size_t size)
+ * @brief Release a range of virtual addresses
+ * @param ptr a pointer returned by mem_region_reserve()
+ * @param size the size in bytes of the range, as passed to mem_region_reserve()
+ */
+
+/**
+ * @fn mem_region_discard(void *ptr, size_t size)
+ * @brief Give back to the OS the memory backing a part of a committed range, which stays accessible
+ * @param ptr a pointer inside a committed range
+ * @param size the size in bytes of the part to discard
+ *
+ * Only the pages entirely contained in the part are discarded; their content is undefined afterwards.
+ */
+
+/**
+ * @fn mem_region_huge_advise(void *ptr, size_t size)
+ * @brief Ask the OS to back a range of virtual addresses with huge pages
+ * @param ptr a page aligned pointer inside a range obtained with mem_region_reserve()
+ * @param size the size in bytes of the range
+ * @return 0 if successful, -1 otherwise
+ */
+
+/**
+ * @fn mem_region_prefault(void *ptr, size_t size)
+ * @brief Fault in a committed range of virtual addresses, so that later accesses don't trigger page faults
+ * @param ptr a page aligned pointer inside a committed range
+ * @param size the size in bytes of the range
+ *
+ * The pages are touched by the calling thread, so that on NUMA machines they are placed close to it.
+ */
+
+/**
+ * @fn mem_file_map(const char *dir, size_t size)
+ * @brief Map in memory a new anonymous file
+ * @param dir the path of the directory which hosts the file
+ * @param size the size in bytes of the file
+ * @return a pointer to the page aligned shared mapping of the file, NULL if unsuccessful
+ *
+ * The file is sparse where supported and it is deleted as soon as it is unmapped.
+ */
+
+/**
+ * @fn mem_file_unmap(void *ptr, size_t size)
+ * @brief Unmap a file mapped with mem_file_map(), which is deleted
+ * @param ptr a pointer returned by mem_file_map()
+ * @param size the size in bytes of the file, as passed to mem_file_map()
+ */
+
+/**
+ * @fn mem_file_discard(void *ptr, size_t size)
+ * @brief Give back the storage which backs a part of a file mapped with mem_file_map()
+ * @param ptr a page aligned pointer inside a mapping returned by mem_file_map()
+ * @param size the size in bytes of the part to discard, a multiple of the page size
+ *
+ * The content of the part is undefined afterwards. Where this isn't supported, the storage is simply kept.
+ */
+
 /**
  * @fn mem_stat_setup(void)
  * @brief Initialize the platform specific memory statistics facilities
@@ -29,9 +107,112 @@
  * @return the size in bytes of the maximal resident set, 0 if unsuccessful
  */
 
+/**
+ * @fn mem_stat_page_faults_get(void)
+ * @brief Get the count of page faults triggered by the calling thread
+ * @return the count of page faults since the thread beginning, 0 if unsuccessful
+ */
+
+/**
+ * @fn mem_stat_phys_get(void)
+ * @brief Get the size of the physical memory of the machine
+ * @return the size in bytes of the physical memory, 0 if unsuccessful
+ */
+
 #ifdef __POSIX
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
 #include <sys/resource.h>
+#include <unistd.h>
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+void *mem_region_reserve(size_t size)
+{
+	void *ret = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return ret == MAP_FAILED ? NULL : ret;
+}
+
+int mem_region_commit(void *ptr, size_t size)
+{
+	return mprotect(ptr, size, PROT_READ | PROT_WRITE);
+}
+
+void mem_region_release(void *ptr, size_t size)
+{
+	munmap(ptr, size);
+}
+
+void mem_region_discard(void *ptr, size_t size)
+{
+	const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+	uintptr_t b = ((uintptr_t)ptr + page_size - 1) & ~(page_size - 1);
+	uintptr_t e = ((uintptr_t)ptr + size) & ~(page_size - 1);
+	if(b < e)
+		madvise((void *)b, e - b, MADV_DONTNEED);
+}
+
+int mem_region_huge_advise(void *ptr, size_t size)
+{
+#ifdef MADV_HUGEPAGE
+	return madvise(ptr, size, MADV_HUGEPAGE);
+#else
+	(void)ptr;
+	(void)size;
+	return -1;
+#endif
+}
+
+void mem_region_prefault(void *ptr, size_t size)
+{
+#ifdef MADV_POPULATE_WRITE
+	if(!madvise(ptr, size, MADV_POPULATE_WRITE))
+		return;
+#endif
+	const size_t page_size = sysconf(_SC_PAGESIZE);
+	for(size_t i = 0; i < size; i += page_size)
+		((volatile unsigned char *)ptr)[i] = 0;
+}
+
+void *mem_file_map(const char *dir, size_t size)
+{
+	int n = snprintf(NULL, 0, "%s/rootsim-XXXXXX", dir);
+	char path[n + 1];
+	snprintf(path, sizeof(path), "%s/rootsim-XXXXXX", dir);
+
+	int fd = mkstemp(path);
+	if(fd == -1)
+		return NULL;
+
+	// the mapping keeps the file alive, and nothing is left behind if the process dies
+	unlink(path);
+
+	void *ret = MAP_FAILED;
+	if(!ftruncate(fd, (off_t)size))
+		ret = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NORESERVE, fd, 0);
+
+	close(fd);
+	return ret == MAP_FAILED ? NULL : ret;
+}
+
+void mem_file_unmap(void *ptr, size_t size)
+{
+	munmap(ptr, size);
+}
+
+void mem_file_discard(void *ptr, size_t size)
+{
+#ifdef MADV_REMOVE
+	madvise(ptr, size, MADV_REMOVE);
+#else
+	(void)ptr;
+	(void)size;
+#endif
+}
 
 #if defined(__MACOS)
 
@@ -77,7 +258,8 @@ int mem_stat_setup(void)
 size_t mem_stat_rss_current_get(void)
 {
 	char res[40]; // sufficient for two 64 bit base 10 numbers and a space
-	if(__builtin_expect(lseek(proc_stat_fd, 0, SEEK_SET) == -1 || read(proc_stat_fd, res, sizeof(res) - 1) == -1, 0))
+	// pread() doesn't move the shared file offset, so that worker threads can query this concurrently
+	if(__builtin_expect(pread(proc_stat_fd, res, sizeof(res) - 1, 0) == -1, 0))
 		return (size_t)0;
 
 	res[sizeof(res) - 1] = '\0';
@@ -116,6 +298,27 @@ size_t mem_stat_rss_max_get(void)
 #endif
 }
 
+size_t mem_stat_page_faults_get(void)
+{
+#ifdef __LINUX
+	struct rusage res;
+	if(__builtin_expect(getrusage(RUSAGE_THREAD, &res), 0))
+		return (size_t)0;
+	return (size_t)res.ru_minflt + (size_t)res.ru_majflt;
+#else
+	return (size_t)0;
+#endif
+}
+
+size_t mem_stat_phys_get(void)
+{
+	long pages = sysconf(_SC_PHYS_PAGES);
+	long page_size = sysconf(_SC_PAGESIZE);
+	if(__builtin_expect(pages <= 0 || page_size <= 0, 0))
+		return (size_t)0;
+	return (size_t)pages * (size_t)page_size;
+}
+
 #endif
 
 #ifdef __WINDOWS
@@ -123,6 +326,88 @@ size_t mem_stat_rss_max_get(void)
 #include <windows.h>
 #include <psapi.h>
 
+void *mem_region_reserve(size_t size)
+{
+	return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+int mem_region_commit(void *ptr, size_t size)
+{
+	return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) == NULL ? -1 : 0;
+}
+
+void mem_region_release(void *ptr, size_t size)
+{
+	(void)size;
+	VirtualFree(ptr, 0, MEM_RELEASE);
+}
+
+void mem_region_discard(void *ptr, size_t size)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	const uintptr_t page_size = info.dwPageSize;
+	uintptr_t b = ((uintptr_t)ptr + page_size - 1) & ~(page_size - 1);
+	uintptr_t e = ((uintptr_t)ptr + size) & ~(page_size - 1);
+	if(b < e)
+		VirtualAlloc((void *)b, e - b, MEM_RESET, PAGE_READWRITE);
+}
+
+int mem_region_huge_advise(void *ptr, size_t size)
+{
+	// large pages need a privilege and can't be requested on an already reserved range
+	(void)ptr;
+	(void)size;
+	return -1;
+}
+
+void mem_region_prefault(void *ptr, size_t size)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	for(size_t i = 0; i < size; i += info.dwPageSize)
+		((volatile unsigned char *)ptr)[i] = 0;
+}
+
+void *mem_file_map(const char *dir, size_t size)
+{
+	char path[MAX_PATH];
+	if(!GetTempFileNameA(dir, "rs", 0, path))
+		return NULL;
+
+	HANDLE f = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+	    FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+	if(f == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	DWORD r;
+	DeviceIoControl(f, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &r, NULL);
+
+	void *ret = NULL;
+	HANDLE m = CreateFileMappingA(f, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, NULL);
+	if(m != NULL) {
+		ret = MapViewOfFile(m, FILE_MAP_ALL_ACCESS, 0, 0, size);
+		CloseHandle(m);
+	}
+
+	// the view keeps the file alive, which is deleted once unmapped
+	CloseHandle(f);
+	return ret;
+}
+
+void mem_file_unmap(void *ptr, size_t size)
+{
+	(void)size;
+	UnmapViewOfFile(ptr);
+}
+
+void mem_file_discard(void *ptr, size_t size)
+{
+	// the handle of the file, needed to deallocate its ranges, isn't kept around
+	(void)ptr;
+	(void)size;
+}
+
 int mem_stat_setup(void)
 {
 	return 0;
@@ -142,4 +427,17 @@ size_t mem_stat_rss_max_get(void)
 	return (size_t)info.PeakWorkingSetSize;
 }
 
+size_t mem_stat_page_faults_get(void)
+{
+	return 0;
+}
+
+size_t mem_stat_phys_get(void)
+{
+	MEMORYSTATUSEX info = {.dwLength = sizeof(info)};
+	if(!GlobalMemoryStatusEx(&info))
+		return (size_t)0;
+	return (size_t)info.ullTotalPhys;
+}
+
 #endif
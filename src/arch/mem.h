@@ -28,6 +28,19 @@
 #endif
 
 
+extern void *mem_region_reserve(size_t size);
+extern int mem_region_commit(void *ptr, size_t size);
+extern void mem_region_release(void *ptr, size_t size);
+extern void mem_region_discard(void *ptr, size_t size);
+extern int mem_region_huge_advise(void *ptr, size_t size);
+extern void mem_region_prefault(void *ptr, size_t size);
+
+extern void *mem_file_map(const char *dir, size_t size);
+extern void mem_file_unmap(void *ptr, size_t size);
+extern void mem_file_discard(void *ptr, size_t size);
+
 extern int mem_stat_setup(void);
 extern size_t mem_stat_rss_max_get(void);
 extern size_t mem_stat_rss_current_get(void);
+extern size_t mem_stat_page_faults_get(void);
+extern size_t mem_stat_phys_get(void);
@@ -63,9 +63,14 @@ void msg_queue_init(void)
 
 /**
  * @brief Finalizes the message queue for the current thread
+ *
+ * With a fast teardown, the queued messages are left to the OS.
  */
 void msg_queue_fini(void)
 {
+	if(global_config.fast_teardown)
+		return;
+
 	for(array_count_t i = 0; i < heap_count(mqp); ++i)
 		msg_allocator_free(heap_items(mqp)[i].m);
 
@@ -73,8 +78,9 @@ void msg_queue_fini(void)
 
 	struct lp_msg *m = atomic_load_explicit(&queues[rid].list, memory_order_relaxed);
 	while(m != NULL) {
+		struct lp_msg *next = m->next;
 		msg_allocator_free(m);
-		m = m->next;
+		m = next;
 	}
 }
 
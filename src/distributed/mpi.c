@@ -12,14 +12,30 @@
 #include <distributed/mpi.h>
 #include <mm/mm.h>
 
+#include <arch/timer.h>
+#include <core/sync.h>
+#include <datatypes/array.h>
 #include <datatypes/msg_queue.h>
+#include <gvt/gvt.h>
 #include <mm/msg_allocator.h>
 
 #include <mpi.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+
+/// The size in bytes of the buffers which batch the remote messages directed to the same node
+#define MPI_BATCH_SIZE (16U << 10U)
+/// The time in microseconds after which a partially filled batch is sent anyway
+#define MPI_BATCH_MAX_AGE 100U
+/// The size in bytes of the rings through which the worker threads hand their remote traffic to the MPI owner thread
+#define MPI_RING_SIZE (1U << 20U)
+/// The count of receives which each receiving thread keeps posted for the incoming batches
+#define MPI_RECV_SLOTS 8U
 
 enum {
 	RS_MSG_TAG = 0,
-	RS_DATA_TAG
+	RS_DATA_TAG,
+	RS_MSG_LARGE_TAG
 };
 
 /// Array of control codes values to be able to get their address for MPI_Send()
@@ -29,6 +45,80 @@ static const enum msg_ctrl_code ctrl_msgs[] = {
 	[MSG_CTRL_TERMINATION] = MSG_CTRL_TERMINATION
 };
 
+/// A batch of remote messages directed to the same node, each one preceded by its size as a uint32_t
+struct mpi_batch {
+	/// The buffer of the batch, NULL if no message has been batched yet
+	unsigned char *buf;
+	/// The size in bytes of @a buf
+	size_t size;
+	/// The size in bytes of the used part of @a buf
+	size_t used;
+	/// The time at which the first message has been added to the batch
+	timer_uint t;
+};
+
+/// A batch which has been handed over to MPI
+struct mpi_batch_sent {
+	/// The MPI request of the send operation
+	MPI_Request req;
+	/// The buffer of the batch, which can't be reused until @a req completes
+	unsigned char *buf;
+	/// The size in bytes of @a buf
+	size_t size;
+};
+
+/// The batches of the current thread, indexed by destination node
+static __thread struct mpi_batch *batches;
+/// The count of non empty batches of the current thread
+static __thread nid_t batches_open;
+/// The batches of the current thread which may still be in transit
+static __thread dyn_array(struct mpi_batch_sent) batches_sent;
+/// The buffers of the completed batches, ready to be reused
+static __thread dyn_array(unsigned char *) batch_bufs;
+/// The buffer where the current thread receives the batches larger than MPI_BATCH_SIZE
+static __thread struct {
+	/// The buffer memory
+	unsigned char *buf;
+	/// The size in bytes of the buffer
+	int size;
+} batch_rcv;
+/// The persistent receives which the current thread keeps posted for the batches and the control messages
+static __thread struct {
+	/// The persistent requests, posted in ring order
+	MPI_Request reqs[MPI_RECV_SLOTS];
+	/// The memory where the requests land, MPI_BATCH_SIZE bytes for each slot
+	unsigned char *bufs;
+	/// The slot whose request has been posted first, hence the first one to be matched
+	unsigned next;
+} rcv_slots;
+/// The count of messages sent by the current thread to each node since the last GVT, NULL if the credit is unlimited
+static __thread uint32_t *credit_used;
+/// Set if the current thread has used up its credit towards some node since the last GVT
+static __thread bool credit_exhausted;
+
+/// The header of a record in a hand-off ring
+struct mpi_ring_rec {
+	/// The id of the destination node
+	nid_t dest;
+	/// The control code to send, zero if the record carries the data of a model message
+	enum msg_ctrl_code ctrl;
+	/// The size in bytes of the message data following the header
+	uint32_t size;
+};
+
+/// A single producer single consumer ring through which a worker thread hands its remote traffic to the MPI owner
+struct mpi_ring {
+	/// The position where the producer writes the next record
+	alignas(CACHE_LINE_SIZE) _Atomic size_t head;
+	/// The position where the consumer reads the next record
+	alignas(CACHE_LINE_SIZE) _Atomic size_t tail;
+	/// The memory of the ring, MPI_RING_SIZE bytes
+	unsigned char *buf;
+};
+
+/// The hand-off rings of the worker threads, NULL unless the MPI traffic is funneled through a single thread
+static struct mpi_ring *rings;
+
 /// The MPI request associated with the non blocking scatter gather collective
 static MPI_Request reduce_sum_scatter_req = MPI_REQUEST_NULL;
 /// The MPI request associated with the non blocking all reduce collective
@@ -84,6 +174,16 @@ void mpi_global_init(int *argc_p, char ***argv_p)
 	nid = helper;
 	MPI_Comm_size(MPI_COMM_WORLD, &helper);
 	n_nodes = helper;
+
+	if(!global_config.mpi_funneled || global_config.n_threads < 2)
+		return;
+
+	rings = mm_aligned_alloc(CACHE_LINE_SIZE, global_config.n_threads * sizeof(*rings));
+	for(rid_t i = 0; i < global_config.n_threads; ++i) {
+		atomic_store_explicit(&rings[i].head, 0, memory_order_relaxed);
+		atomic_store_explicit(&rings[i].tail, 0, memory_order_relaxed);
+		rings[i].buf = i ? mm_alloc(MPI_RING_SIZE) : NULL;
+	}
 }
 
 /**
@@ -96,6 +196,310 @@ void mpi_global_fini(void)
 	MPI_Errhandler_free(&err_handler);
 
 	MPI_Finalize();
+
+	if(rings == NULL)
+		return;
+
+	for(rid_t i = 1; i < global_config.n_threads; ++i)
+		mm_free(rings[i].buf);
+	mm_aligned_free(rings);
+	rings = NULL;
+}
+
+/**
+ * @brief Checks if the current thread issues the MPI calls for the remote messages of the node
+ * @return true if the current thread owns the MPI traffic, false if it hands it over through its ring
+ */
+static inline bool mpi_is_owner(void)
+{
+	return rings == NULL || !rid;
+}
+
+/**
+ * @brief Copies some data in a hand-off ring
+ * @param r the target ring
+ * @param pos the position in the ring where to copy the data
+ * @param data the data to copy
+ * @param size the size in bytes of @p data
+ */
+static void mpi_ring_copy_in(struct mpi_ring *r, size_t pos, const void *data, size_t size)
+{
+	size_t off = pos & (MPI_RING_SIZE - 1);
+	size_t first = min(size, MPI_RING_SIZE - off);
+	memcpy(r->buf + off, data, first);
+	memcpy(r->buf, (const unsigned char *)data + first, size - first);
+}
+
+/**
+ * @brief Copies some data out of a hand-off ring
+ * @param r the source ring
+ * @param pos the position in the ring of the data
+ * @param data where to copy the data
+ * @param size the size in bytes of the data
+ */
+static void mpi_ring_copy_out(const struct mpi_ring *r, size_t pos, void *data, size_t size)
+{
+	size_t off = pos & (MPI_RING_SIZE - 1);
+	size_t first = min(size, MPI_RING_SIZE - off);
+	memcpy(data, r->buf + off, first);
+	memcpy((unsigned char *)data + first, r->buf, size - first);
+}
+
+/**
+ * @brief Hands a record over to the MPI owner thread through the ring of the current thread
+ * @param rec the header of the record
+ * @param data the message data of the record, if any
+ * @return true if the record has been handed over, false if the ring has no room for it
+ */
+static bool mpi_ring_push(const struct mpi_ring_rec *rec, const void *data)
+{
+	struct mpi_ring *r = &rings[rid];
+	size_t r_size = sizeof(*rec) + rec->size;
+	size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+	if(unlikely(head + r_size - atomic_load_explicit(&r->tail, memory_order_acquire) > MPI_RING_SIZE))
+		return false;
+
+	mpi_ring_copy_in(r, head, rec, sizeof(*rec));
+	if(rec->size)
+		mpi_ring_copy_in(r, head + sizeof(*rec), data, rec->size);
+	atomic_store_explicit(&r->head, head + r_size, memory_order_release);
+	return true;
+}
+
+/**
+ * @brief Recycles the buffers of the batches whose send operation has completed
+ */
+static void mpi_batch_reap(void)
+{
+	array_count_t i = 0;
+	while(i < array_count(batches_sent)) {
+		struct mpi_batch_sent *b = &array_get_at(batches_sent, i);
+		int flag;
+		MPI_Test(&b->req, &flag, MPI_STATUS_IGNORE);
+		if(!flag) {
+			++i;
+			continue;
+		}
+
+		if(b->size == MPI_BATCH_SIZE)
+			array_push(batch_bufs, b->buf);
+		else
+			mm_free(b->buf);
+		array_lazy_remove_at(batches_sent, i);
+	}
+}
+
+/**
+ * @brief Sends the batch directed to a node
+ * @param dest_nid the id of the destination node of the batch, which must not be empty
+ */
+static void mpi_batch_flush(nid_t dest_nid)
+{
+	struct mpi_batch *b = &batches[dest_nid];
+	struct mpi_batch_sent s = {.buf = b->buf, .size = b->size};
+	int tag = likely(b->used <= MPI_BATCH_SIZE) ? RS_MSG_TAG : RS_MSG_LARGE_TAG;
+	MPI_Isend(b->buf, b->used, MPI_BYTE, dest_nid, tag, MPI_COMM_WORLD, &s.req);
+	array_push(batches_sent, s);
+
+	b->buf = NULL;
+	b->used = 0;
+	--batches_open;
+}
+
+/**
+ * @brief Reserves room for the data of a remote message in the batch directed to a node
+ * @param dest_nid the id of the destination node
+ * @param size the size in bytes of the message data
+ * @return a pointer to the memory where the message data has to be copied
+ *
+ * The batch is sent beforehand if it can't host the new message.
+ */
+static void *mpi_batch_reserve(nid_t dest_nid, uint32_t size)
+{
+	struct mpi_batch *b = &batches[dest_nid];
+	size_t r_size = sizeof(size) + size;
+	if(b->buf != NULL && b->used + r_size > b->size)
+		mpi_batch_flush(dest_nid);
+
+	if(b->buf == NULL) {
+		mpi_batch_reap();
+		if(likely(r_size <= MPI_BATCH_SIZE && !array_is_empty(batch_bufs))) {
+			b->buf = array_pop(batch_bufs);
+			b->size = MPI_BATCH_SIZE;
+		} else {
+			b->size = max(r_size, (size_t)MPI_BATCH_SIZE);
+			b->buf = mm_alloc(b->size);
+		}
+		b->t = timer_new();
+		++batches_open;
+	}
+
+	memcpy(b->buf + b->used, &size, sizeof(size));
+	void *ret = b->buf + b->used + sizeof(size);
+	b->used += r_size;
+	return ret;
+}
+
+/**
+ * @brief Sends the data of a remote message to a node
+ * @param dest_nid the id of the destination node
+ * @param data the data of the message to send
+ * @param size the size in bytes of @p data
+ *
+ * The owner thread batches the data directly, the other threads hand it over through their ring. If the ring has no
+ * room for the data, the current thread sends it right away instead of waiting for the owner thread: the message
+ * may then overtake messages still in the ring, which the anti-messages matching already copes with.
+ */
+static void mpi_remote_data_send(nid_t dest_nid, const void *data, uint32_t size)
+{
+	if(mpi_is_owner()) {
+		memcpy(mpi_batch_reserve(dest_nid, size), data, size);
+		return;
+	}
+
+	struct mpi_ring_rec rec = {.dest = dest_nid, .ctrl = 0, .size = size};
+	if(likely(mpi_ring_push(&rec, data)))
+		return;
+
+	memcpy(mpi_batch_reserve(dest_nid, size), data, size);
+	mpi_batch_flush(dest_nid);
+}
+
+/**
+ * @brief Sends a platform control message, bypassing the hand-off rings
+ * @param ctrl the control message to send
+ * @param dest the id of the destination node
+ */
+static void mpi_control_msg_isend(enum msg_ctrl_code ctrl, nid_t dest)
+{
+	MPI_Request req;
+	MPI_Isend(&ctrl_msgs[ctrl], sizeof(*ctrl_msgs), MPI_BYTE, dest, RS_MSG_TAG, MPI_COMM_WORLD, &req);
+	MPI_Request_free(&req);
+}
+
+/**
+ * @brief Moves the traffic handed over by the other worker threads into the batches of the owner thread
+ */
+static void mpi_rings_pump(void)
+{
+	for(rid_t i = 1; i < global_config.n_threads; ++i) {
+		struct mpi_ring *r = &rings[i];
+		size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+		size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+		if(tail == head)
+			continue;
+
+		do {
+			struct mpi_ring_rec rec;
+			mpi_ring_copy_out(r, tail, &rec, sizeof(rec));
+			tail += sizeof(rec);
+			if(rec.ctrl) {
+				mpi_control_msg_isend(rec.ctrl, rec.dest);
+			} else {
+				mpi_ring_copy_out(r, tail, mpi_batch_reserve(rec.dest, rec.size), rec.size);
+				tail += rec.size;
+			}
+		} while(tail != head);
+
+		atomic_store_explicit(&r->tail, tail, memory_order_release);
+	}
+}
+
+/**
+ * @brief Sends all the non empty batches of the current thread
+ *
+ * This is called by the GVT algorithm when the current thread switches phase, so that the remote messages accounted
+ * in the previous phase actually reach their destination.
+ */
+void mpi_remote_msg_flush(void)
+{
+	for(nid_t i = 0; batches_open && i < n_nodes; ++i)
+		if(batches[i].buf != NULL)
+			mpi_batch_flush(i);
+}
+
+/**
+ * @brief Sends the batches of the current thread which have been waiting for too long
+ */
+static void mpi_batch_flush_aged(void)
+{
+	if(likely(!batches_open))
+		return;
+
+	timer_uint t = timer_new();
+	for(nid_t i = 0; batches_open && i < n_nodes; ++i)
+		if(batches[i].buf != NULL && t - batches[i].t >= MPI_BATCH_MAX_AGE)
+			mpi_batch_flush(i);
+}
+
+/**
+ * @brief Initializes the MPI remote messaging state of the current thread
+ */
+void mpi_remote_msg_init(void)
+{
+	batches = mm_alloc(n_nodes * sizeof(*batches));
+	memset(batches, 0, n_nodes * sizeof(*batches));
+	batches_open = 0;
+	array_init(batches_sent);
+	array_init(batch_bufs);
+	batch_rcv.buf = NULL;
+	batch_rcv.size = 0;
+
+	credit_used = NULL;
+	credit_exhausted = false;
+	if(global_config.remote_credit) {
+		credit_used = mm_alloc(n_nodes * sizeof(*credit_used));
+		memset(credit_used, 0, n_nodes * sizeof(*credit_used));
+	}
+
+	rcv_slots.bufs = NULL;
+	if(!mpi_is_owner())
+		return;
+
+	rcv_slots.bufs = mm_alloc(MPI_RECV_SLOTS * MPI_BATCH_SIZE);
+	for(unsigned i = 0; i < MPI_RECV_SLOTS; ++i)
+		MPI_Recv_init(rcv_slots.bufs + i * MPI_BATCH_SIZE, MPI_BATCH_SIZE, MPI_BYTE, MPI_ANY_SOURCE, RS_MSG_TAG,
+		    MPI_COMM_WORLD, &rcv_slots.reqs[i]);
+	MPI_Startall(MPI_RECV_SLOTS, rcv_slots.reqs);
+	rcv_slots.next = 0;
+}
+
+/**
+ * @brief Finalizes the MPI remote messaging state of the current thread
+ *
+ * This waits for the completion of the batches still in transit, which at this point have all been received, and
+ * cancels the receives still posted. The other worker threads must not hand over any more traffic to the owner thread
+ * when this is called.
+ */
+void mpi_remote_msg_fini(void)
+{
+	if(rings != NULL && !rid)
+		mpi_rings_pump();
+	mpi_remote_msg_flush();
+	while(!array_is_empty(batches_sent)) {
+		struct mpi_batch_sent b = array_pop(batches_sent);
+		MPI_Wait(&b.req, MPI_STATUS_IGNORE);
+		mm_free(b.buf);
+	}
+	array_fini(batches_sent);
+
+	while(!array_is_empty(batch_bufs))
+		mm_free(array_pop(batch_bufs));
+	array_fini(batch_bufs);
+
+	mm_free(batches);
+	mm_free(batch_rcv.buf);
+	mm_free(credit_used);
+
+	if(rcv_slots.bufs == NULL)
+		return;
+
+	for(unsigned i = 0; i < MPI_RECV_SLOTS; ++i) {
+		MPI_Cancel(&rcv_slots.reqs[i]);
+		MPI_Wait(&rcv_slots.reqs[i], MPI_STATUS_IGNORE);
+		MPI_Request_free(&rcv_slots.reqs[i]);
+	}
+	mm_free(rcv_slots.bufs);
 }
 
 /**
@@ -104,17 +508,43 @@ void mpi_global_fini(void)
  * @param dest_nid the id of the node where the targeted LP resides
  *
  * This function also calls the relevant handlers in order to keep, for example, the non blocking gvt algorithm running.
- * Note that when this function returns, the message may have not been actually sent. We don't need to actively check
- * for sending completion: the platform, during the fossil collection, leverages the gvt to make sure the message has
- * been indeed sent and processed before freeing it.
+ * The message data is copied in the batch directed to @p dest_nid, which is sent when full, when too old or when the
+ * GVT algorithm switches phase.
  */
 void mpi_remote_msg_send(struct lp_msg *msg, nid_t dest_nid)
 {
 	gvt_remote_msg_send(msg, dest_nid);
+	mpi_remote_data_send(dest_nid, msg_remote_data(msg), msg_remote_size(msg));
 
-	MPI_Request req;
-	MPI_Isend(msg_remote_data(msg), msg_remote_size(msg), MPI_BYTE, dest_nid, RS_MSG_TAG, MPI_COMM_WORLD, &req);
-	MPI_Request_free(&req);
+	if(unlikely(credit_used != NULL) && ++credit_used[dest_nid] >= global_config.remote_credit)
+		credit_exhausted = true;
+}
+
+/**
+ * @brief Checks if the current thread has to hold back its event processing
+ * @return true if the current thread has used up its credit towards some node since the last GVT, false otherwise
+ *
+ * A thread which outruns its credit keeps serving the incoming messages and the GVT algorithm, but it doesn't process
+ * new events until the credit is given back by mpi_remote_msg_on_gvt(). The anti-messages never consume credit.
+ */
+bool mpi_remote_msg_throttled(void)
+{
+	return credit_exhausted;
+}
+
+/**
+ * @brief Gives back the remote message credit of the current thread
+ *
+ * This is called after a fresh GVT has been computed: at that point, all the messages the thread sent in the previous
+ * GVT phase have reached their destination, so the credit spent on them can be granted again.
+ */
+void mpi_remote_msg_on_gvt(void)
+{
+	if(likely(credit_used == NULL))
+		return;
+
+	memset(credit_used, 0, n_nodes * sizeof(*credit_used));
+	credit_exhausted = false;
 }
 
 /**
@@ -123,17 +553,12 @@ void mpi_remote_msg_send(struct lp_msg *msg, nid_t dest_nid)
  * @param dest_nid the id of the node where the targeted LP resides
  *
  * This function also calls the relevant handlers in order to keep, for example, the non blocking gvt algorithm running.
- * Note that when this function returns, the anti-message may have not been sent yet. We don't need to actively check
- * for sending completion: the platform, during the fossil collection, leverages the gvt to make sure the message has
- * been indeed sent and processed before freeing it.
+ * The anti-message is batched like the regular messages, after the message it annihilates if this is still pending.
  */
 void mpi_remote_anti_msg_send(struct lp_msg *msg, nid_t dest_nid)
 {
 	gvt_remote_anti_msg_send(msg, dest_nid);
-
-	MPI_Request req;
-	MPI_Isend(msg_remote_data(msg), msg_remote_anti_size(), MPI_BYTE, dest_nid, RS_MSG_TAG, MPI_COMM_WORLD, &req);
-	MPI_Request_free(&req);
+	mpi_remote_data_send(dest_nid, msg_remote_data(msg), msg_remote_anti_size());
 }
 
 /**
@@ -155,102 +580,143 @@ void mpi_control_msg_broadcast(enum msg_ctrl_code ctrl)
  */
 void mpi_control_msg_send_to(enum msg_ctrl_code ctrl, nid_t dest)
 {
-	MPI_Request req;
-	MPI_Isend(&ctrl_msgs[ctrl], sizeof(*ctrl_msgs), MPI_BYTE, dest, RS_MSG_TAG, MPI_COMM_WORLD, &req);
-	MPI_Request_free(&req);
+	if(mpi_is_owner()) {
+		mpi_control_msg_isend(ctrl, dest);
+		return;
+	}
+
+	struct mpi_ring_rec rec = {.dest = dest, .ctrl = ctrl, .size = 0};
+	if(unlikely(!mpi_ring_push(&rec, NULL)))
+		mpi_control_msg_isend(ctrl, dest);
 }
 
 /**
- * @brief Empties the queue of incoming MPI messages, doing the right thing for
- *        each one of them.
- *
- * This routine checks, using the MPI probing mechanism, for new remote messages and it handles them accordingly.
- * Control messages are handled by the respective platform handler. Simulation messages are unpacked and put in the
- * queue. Anti-messages are matched and accordingly processed by the message map.
+ * @brief Unpacks the messages of a received batch
+ * @param buf the buffer holding the batch
+ * @param size the size in bytes of the batch
+ * @param discard if set, the messages are only accounted for the GVT algorithm and then released
  */
-void mpi_remote_msg_handle(void)
+static void mpi_batch_unpack(const unsigned char *buf, int size, bool discard)
 {
-	while(1) {
-		int pending;
-		MPI_Message mpi_msg;
-		MPI_Status status;
-
-		MPI_Improbe(MPI_ANY_SOURCE, RS_MSG_TAG, MPI_COMM_WORLD, &pending, &mpi_msg, &status);
-
-		if(!pending)
-			return;
+	const unsigned char *end = buf + size;
+	while(buf < end) {
+		uint32_t m_size;
+		memcpy(&m_size, buf, sizeof(m_size));
+		buf += sizeof(m_size);
 
-		int size;
-		MPI_Get_count(&status, MPI_BYTE, &size);
 		struct lp_msg *msg;
-		if(unlikely(size <= (int)msg_remote_anti_size())) {
-			if(unlikely(size == sizeof(enum msg_ctrl_code))) {
-				enum msg_ctrl_code c;
-				MPI_Mrecv(&c, sizeof(c), MPI_BYTE, &mpi_msg, MPI_STATUS_IGNORE);
-				control_msg_process(c);
-				continue;
-			}
+		if(m_size == msg_remote_anti_size()) {
 			msg = msg_allocator_alloc(0);
 			// make sure the deterministic tie-breaking doesn't read uninitialized data
 			msg->m_type = 0;
 			msg->pl_size = 0;
-			MPI_Mrecv(msg_remote_data(msg), size, MPI_BYTE, &mpi_msg, MPI_STATUS_IGNORE);
-
+			memcpy(msg_remote_data(msg), buf, m_size);
 			gvt_remote_anti_msg_receive(msg);
 		} else {
-			msg = msg_allocator_alloc(size - offsetof(struct lp_msg, pl) + msg_preamble_size());
-			MPI_Mrecv(msg_remote_data(msg), size, MPI_BYTE, &mpi_msg, MPI_STATUS_IGNORE);
-
+			msg = msg_allocator_alloc(m_size - offsetof(struct lp_msg, pl) + msg_preamble_size());
+			memcpy(msg_remote_data(msg), buf, m_size);
 			gvt_remote_msg_receive(msg);
 		}
-		msg_queue_insert(msg);
+		buf += m_size;
+
+		if(unlikely(discard))
+			msg_allocator_free(msg);
+		else
+			msg_queue_insert(msg);
 	}
 }
 
 /**
- * @brief Empties the queue of incoming MPI messages, ignoring them
- *
- * This routine checks, using the MPI probing mechanism, for new remote messages and it discards them. It is used at
- * simulation completion to clear MPI state.
+ * @brief Receives the pending MPI messages, doing the right thing for each one of them
+ * @param discard if set, the model messages are discarded
  */
-void mpi_remote_msg_drain(void)
+static void mpi_remote_msg_receive(bool discard)
 {
-	struct lp_msg *msg = NULL;
-	int msg_size = 0;
+	while(1) {
+		MPI_Request *req = &rcv_slots.reqs[rcv_slots.next];
+		int done;
+		MPI_Status status;
+		MPI_Test(req, &done, &status);
+		if(!done)
+			break;
+
+		int size;
+		MPI_Get_count(&status, MPI_BYTE, &size);
+
+		unsigned char *buf = rcv_slots.bufs + rcv_slots.next * MPI_BATCH_SIZE;
+		if(unlikely(size == sizeof(enum msg_ctrl_code))) {
+			enum msg_ctrl_code c;
+			memcpy(&c, buf, sizeof(c));
+			control_msg_process(c);
+		} else {
+			mpi_batch_unpack(buf, size, discard);
+		}
+
+		// the slot goes at the back of the ring, so that the ring order is the matching order
+		MPI_Start(req);
+		rcv_slots.next = (rcv_slots.next + 1) % MPI_RECV_SLOTS;
+	}
 
 	while(1) {
 		int pending;
 		MPI_Message mpi_msg;
 		MPI_Status status;
 
-		MPI_Improbe(MPI_ANY_SOURCE, RS_MSG_TAG, MPI_COMM_WORLD, &pending, &mpi_msg, &status);
+		MPI_Improbe(MPI_ANY_SOURCE, RS_MSG_LARGE_TAG, MPI_COMM_WORLD, &pending, &mpi_msg, &status);
 
 		if(!pending)
-			break;
+			return;
 
 		int size;
 		MPI_Get_count(&status, MPI_BYTE, &size);
 
-		if(unlikely(size == sizeof(enum msg_ctrl_code))) {
-			enum msg_ctrl_code c;
-			MPI_Mrecv(&c, sizeof(c), MPI_BYTE, &mpi_msg, MPI_STATUS_IGNORE);
-			control_msg_process(c);
-			continue;
+		if(unlikely(size > batch_rcv.size)) {
+			batch_rcv.buf = mm_realloc(batch_rcv.buf, size);
+			batch_rcv.size = size;
 		}
+		MPI_Mrecv(batch_rcv.buf, size, MPI_BYTE, &mpi_msg, MPI_STATUS_IGNORE);
+		mpi_batch_unpack(batch_rcv.buf, size, discard);
+	}
+}
 
-		if(size > msg_size) {
-			msg = mm_realloc(msg, size + msg_preamble_size());
-			msg_size = size;
-		}
-		MPI_Mrecv(msg_remote_data(msg), size, MPI_BYTE, &mpi_msg, MPI_STATUS_IGNORE);
+/**
+ * @brief Empties the queue of incoming MPI messages, doing the right thing for
+ *        each one of them.
+ *
+ * This routine checks the receives posted by the current thread for new remote messages and it handles them
+ * accordingly, then it probes for the batches too large for the posted receives. Control messages are handled by the
+ * respective platform handler. Batches of simulation messages are unpacked and their messages are put in the queue. The batches of the current thread which have been waiting for too long are
+ * sent as well.
+ *
+ * If the MPI traffic is funneled, only the first worker thread does this work, after having moved in its batches the
+ * traffic handed over by the other threads; for the other threads this is a no-op.
+ */
+void mpi_remote_msg_handle(void)
+{
+	if(!mpi_is_owner())
+		return;
 
-		if(size == msg_remote_anti_size())
-			gvt_remote_anti_msg_receive(msg);
-		else
-			gvt_remote_msg_receive(msg);
-	}
+	if(rings != NULL)
+		mpi_rings_pump();
+	mpi_batch_flush_aged();
+	mpi_remote_msg_receive(false);
+}
+
+/**
+ * @brief Empties the queue of incoming MPI messages, ignoring them
+ *
+ * This routine checks for new remote messages and it discards them. It is used at simulation completion to clear MPI
+ * state.
+ */
+void mpi_remote_msg_drain(void)
+{
+	if(!mpi_is_owner())
+		return;
 
-	mm_free(msg);
+	if(rings != NULL)
+		mpi_rings_pump();
+	mpi_remote_msg_flush();
+	mpi_remote_msg_receive(true);
 }
 
 /**
@@ -21,6 +21,11 @@
 extern void mpi_global_init(int *argc_p, char ***argv_p);
 extern void mpi_global_fini(void);
 
+extern void mpi_remote_msg_init(void);
+extern void mpi_remote_msg_fini(void);
+extern void mpi_remote_msg_flush(void);
+extern bool mpi_remote_msg_throttled(void);
+extern void mpi_remote_msg_on_gvt(void);
 extern void mpi_remote_msg_send(struct lp_msg *msg, nid_t dest_nid);
 extern void mpi_remote_anti_msg_send(struct lp_msg *msg, nid_t dest_nid);
 
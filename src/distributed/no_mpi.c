@@ -26,6 +26,19 @@ void mpi_global_init(int *argc_p, char ***argv_p)
 
 void mpi_global_fini(void) {}
 
+void mpi_remote_msg_init(void) {}
+
+void mpi_remote_msg_fini(void) {}
+
+void mpi_remote_msg_flush(void) {}
+
+bool mpi_remote_msg_throttled(void)
+{
+	return false;
+}
+
+void mpi_remote_msg_on_gvt(void) {}
+
 void mpi_remote_msg_send(struct lp_msg *msg, nid_t dest_nid)
 {
 	(void)msg;
@@ -0,0 +1,707 @@
+/**
+ * @file distributed/shm.c
+ *
+ * @brief Shared memory transport
+ *
+ * This module implements the facilities of distributed/mpi.h for several processes running on the same machine, which
+ * communicate through a POSIX shared memory segment instead of MPI. The processes are started by the rootsim-shm-run
+ * launcher, which passes to each of them the segment name, the count of processes and its node id through the
+ * environment. A process started without the launcher runs as the only node of the simulation.
+ *
+ * The segment hosts a ring for each worker thread and each destination node, which carries the remote messages and
+ * the control messages, a ring for each pair of nodes, which carries the blocking data transfers, and the buffers of
+ * the collective operations. Every structure starts zeroed, so that no process has to initialize the segment on behalf
+ * of the others.
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <distributed/mpi.h>
+
+#include <core/sync.h>
+#include <datatypes/array.h>
+#include <datatypes/msg_queue.h>
+#include <gvt/gvt.h>
+#include <log/log.h>
+#include <mm/mm.h>
+#include <mm/msg_allocator.h>
+
+#include <fcntl.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/// The size in bytes of the rings carrying the remote messages and the control messages
+#define SHM_MSG_RING_SIZE (1U << 18U)
+/// The size in bytes of the rings carrying the blocking data transfers
+#define SHM_DATA_RING_SIZE (1U << 16U)
+/// The flag which marks the header of a ring record carrying a control message instead of a message size
+#define SHM_CTRL_FLAG (1U << 31U)
+
+/// The indexes of a ring, each one in its own cache line since they are written by different processes
+struct shm_ring {
+	/// The position where the producer writes the next record
+	alignas(CACHE_LINE_SIZE) _Atomic uint64_t head;
+	/// The position where the consumer reads the next record
+	alignas(CACHE_LINE_SIZE) _Atomic uint64_t tail;
+	/// Set while a thread of the destination node is consuming the ring
+	_Atomic bool busy;
+};
+
+/// The header of the shared memory segment
+struct shm_header {
+	/// The count of nodes plus one, set by the first process which attaches to the segment
+	_Atomic uint32_t n_nodes;
+	/// The count of worker threads of each node plus one, set by the first process which attaches to the segment
+	_Atomic uint32_t n_threads;
+	/// The count of node arrivals to the barriers so far
+	alignas(CACHE_LINE_SIZE) _Atomic uint64_t barrier_arrived;
+	/// The count of node contributions to the sum-reduction-scatter operations so far
+	alignas(CACHE_LINE_SIZE) _Atomic uint64_t sum_arrived;
+	/// The count of node contributions to the min-reduction operations so far
+	alignas(CACHE_LINE_SIZE) _Atomic uint64_t min_arrived;
+};
+
+/// The mapping of the shared memory segment
+static unsigned char *seg;
+/// The size in bytes of the shared memory segment
+static size_t seg_size;
+/// The header of the segment
+static struct shm_header *hdr;
+/// The contributions to the sum-reduction-scatter operations, a n_nodes x n_nodes matrix for each of two rounds
+static uint32_t *sum_vals;
+/// The contributions to the min-reduction operations, n_nodes values for each of two rounds
+static double *min_vals;
+/// The indexes of the message rings, addressed with msg_ring_idx()
+static struct shm_ring *msg_rings;
+/// The indexes of the data rings, addressed with data_ring_idx()
+static struct shm_ring *data_rings;
+/// The memory of the message rings, SHM_MSG_RING_SIZE bytes for each ring
+static unsigned char *msg_bufs;
+/// The memory of the data rings, SHM_DATA_RING_SIZE bytes for each ring
+static unsigned char *data_bufs;
+
+/// The count of barriers entered by this node
+static uint64_t barrier_round;
+/// The count of sum-reduction-scatter operations started by this node
+static uint64_t sum_round;
+/// The count of min-reduction operations started by this node
+static uint64_t min_round;
+/// Where to store the result of the pending sum-reduction-scatter operation, NULL if there's none
+static uint32_t *sum_result;
+/// Where to store the result of the pending min-reduction operation, NULL if there's none
+static double *min_result;
+
+/// Set between mpi_remote_msg_init() and mpi_remote_msg_fini(), while the current thread can consume its incoming rings
+static __thread bool rcv_active;
+/// Set once the simulation is over and the current thread started discarding the incoming messages
+static __thread bool rcv_discard;
+/// Set while the current thread consumes its incoming rings because it is waiting for the other nodes
+static __thread bool rcv_nested;
+/// The control messages received while @a rcv_nested was set, which are processed at the next polling
+static __thread dyn_array(enum msg_ctrl_code) ctrl_deferred;
+/// The count of messages sent by the current thread to each node since the last GVT, NULL if the credit is unlimited
+static __thread uint32_t *credit_used;
+/// Set if the current thread has used up its credit towards some node since the last GVT
+static __thread bool credit_exhausted;
+
+/**
+ * @brief Computes the index of a message ring
+ * @param dest the id of the destination node
+ * @param src the id of the source node
+ * @param src_rid the id of the source worker thread
+ * @return the index of the ring in @a msg_rings
+ */
+static inline size_t msg_ring_idx(nid_t dest, nid_t src, rid_t src_rid)
+{
+	return ((size_t)dest * n_nodes + src) * global_config.n_threads + src_rid;
+}
+
+/**
+ * @brief Computes the index of a data ring
+ * @param dest the id of the destination node
+ * @param src the id of the source node
+ * @return the index of the ring in @a data_rings
+ */
+static inline size_t data_ring_idx(nid_t dest, nid_t src)
+{
+	return (size_t)dest * n_nodes + src;
+}
+
+/**
+ * @brief Copies some data in a ring
+ * @param buf the memory of the ring
+ * @param ring_size the size in bytes of @p buf, a power of 2
+ * @param pos the position in the ring where to copy the data
+ * @param data the data to copy
+ * @param size the size in bytes of @p data
+ */
+static void shm_copy_in(unsigned char *buf, size_t ring_size, uint64_t pos, const void *data, size_t size)
+{
+	size_t off = pos & (ring_size - 1);
+	size_t first = min(size, ring_size - off);
+	memcpy(buf + off, data, first);
+	memcpy(buf, (const unsigned char *)data + first, size - first);
+}
+
+/**
+ * @brief Copies some data out of a ring
+ * @param buf the memory of the ring
+ * @param ring_size the size in bytes of @p buf, a power of 2
+ * @param pos the position in the ring of the data
+ * @param data where to copy the data
+ * @param size the size in bytes of the data
+ */
+static void shm_copy_out(const unsigned char *buf, size_t ring_size, uint64_t pos, void *data, size_t size)
+{
+	size_t off = pos & (ring_size - 1);
+	size_t first = min(size, ring_size - off);
+	memcpy(data, buf + off, first);
+	memcpy((unsigned char *)data + first, buf, size - first);
+}
+
+/**
+ * @brief Maps the shared memory segment
+ * @param size the size in bytes of the segment
+ *
+ * The segment named by the launcher is created by the first process which gets here; a process started without the
+ * launcher maps a private zeroed region instead.
+ */
+static void shm_segment_map(size_t size)
+{
+	const char *name = getenv("ROOTSIM_SHM_NAME");
+	if(name == NULL) {
+		seg = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	} else {
+		int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+		if(unlikely(fd == -1 || ftruncate(fd, size))) {
+			logger(LOG_FATAL, "Unable to create the shared memory segment %s", name);
+			abort();
+		}
+		seg = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+	}
+
+	if(unlikely(seg == MAP_FAILED)) {
+		logger(LOG_FATAL, "Unable to map the shared memory segment");
+		abort();
+	}
+	seg_size = size;
+}
+
+/**
+ * @brief Checks that all the processes agree on a value of the configuration
+ * @param val_p a pointer to the shared copy of the value
+ * @param val the value of this process
+ * @param what the description of the value, used in the error message
+ */
+static void shm_config_check(_Atomic uint32_t *val_p, uint32_t val, const char *what)
+{
+	uint32_t exp = 0;
+	if(atomic_compare_exchange_strong_explicit(val_p, &exp, val + 1, memory_order_relaxed, memory_order_relaxed) ||
+	    exp == val + 1)
+		return;
+
+	logger(LOG_FATAL, "The processes disagree on the %s: %u vs %u", what, exp - 1, val);
+	abort();
+}
+
+/**
+ * @brief Initializes the shared memory transport
+ * @param argc_p unused
+ * @param argv_p unused
+ */
+void mpi_global_init(int *argc_p, char ***argv_p)
+{
+	(void)argc_p;
+	(void)argv_p;
+
+	const char *nodes_str = getenv("ROOTSIM_SHM_NODES");
+	const char *nid_str = getenv("ROOTSIM_SHM_NID");
+	n_nodes = nodes_str != NULL ? atoi(nodes_str) : 1;
+	nid = nid_str != NULL ? atoi(nid_str) : 0;
+	if(unlikely(n_nodes < 1 || n_nodes > MAX_NODES || nid < 0 || nid >= n_nodes)) {
+		logger(LOG_FATAL, "Invalid shared memory transport environment: node %d of %d", nid, n_nodes);
+		abort();
+	}
+
+	size_t nn = (size_t)n_nodes * n_nodes;
+	size_t msg_rings_cnt = nn * global_config.n_threads;
+	size_t sum_off = (sizeof(struct shm_header) + CACHE_LINE_SIZE - 1) & ~((size_t)CACHE_LINE_SIZE - 1);
+	size_t min_off = sum_off + 2 * nn * sizeof(*sum_vals);
+	size_t msg_rings_off = (min_off + 2 * n_nodes * sizeof(*min_vals) + CACHE_LINE_SIZE - 1) &
+	    ~((size_t)CACHE_LINE_SIZE - 1);
+	size_t data_rings_off = msg_rings_off + msg_rings_cnt * sizeof(*msg_rings);
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t msg_bufs_off = (data_rings_off + nn * sizeof(*data_rings) + page - 1) & ~(page - 1);
+	size_t data_bufs_off = msg_bufs_off + msg_rings_cnt * SHM_MSG_RING_SIZE;
+
+	shm_segment_map(data_bufs_off + nn * SHM_DATA_RING_SIZE);
+	hdr = (struct shm_header *)seg;
+	sum_vals = (uint32_t *)(seg + sum_off);
+	min_vals = (double *)(seg + min_off);
+	msg_rings = (struct shm_ring *)(seg + msg_rings_off);
+	data_rings = (struct shm_ring *)(seg + data_rings_off);
+	msg_bufs = seg + msg_bufs_off;
+	data_bufs = seg + data_bufs_off;
+
+	barrier_round = 0;
+	sum_round = 0;
+	min_round = 0;
+	sum_result = NULL;
+	min_result = NULL;
+
+	shm_config_check(&hdr->n_nodes, n_nodes, "count of nodes");
+	shm_config_check(&hdr->n_threads, global_config.n_threads, "count of threads");
+}
+
+/**
+ * @brief Finalizes the shared memory transport
+ *
+ * The segment itself is removed by the launcher, once all the processes have exited.
+ */
+void mpi_global_fini(void)
+{
+	munmap(seg, seg_size);
+	seg = NULL;
+}
+
+/**
+ * @brief Initializes the remote messaging state of the current thread
+ */
+void mpi_remote_msg_init(void)
+{
+	rcv_active = true;
+	rcv_discard = false;
+	rcv_nested = false;
+	array_init(ctrl_deferred);
+
+	credit_used = NULL;
+	credit_exhausted = false;
+	if(global_config.remote_credit) {
+		credit_used = mm_alloc(n_nodes * sizeof(*credit_used));
+		memset(credit_used, 0, n_nodes * sizeof(*credit_used));
+	}
+}
+
+/**
+ * @brief Finalizes the remote messaging state of the current thread
+ */
+void mpi_remote_msg_fini(void)
+{
+	rcv_active = false;
+	array_fini(ctrl_deferred);
+	mm_free(credit_used);
+}
+
+/**
+ * @brief Sends the pending remote messages of the current thread
+ *
+ * The rings deliver each message as soon as it is sent, so there's nothing to do here.
+ */
+void mpi_remote_msg_flush(void) {}
+
+/**
+ * @brief Handles a received control message
+ * @param ctrl the control message
+ */
+static void shm_ctrl_msg_process(enum msg_ctrl_code ctrl)
+{
+	if(unlikely(rcv_nested))
+		array_push(ctrl_deferred, ctrl);
+	else
+		control_msg_process(ctrl);
+}
+
+/**
+ * @brief Consumes the rings directed to this node, doing the right thing for each record
+ * @param discard if set, the model messages are only accounted for the GVT algorithm and then released
+ *
+ * Each ring is consumed by a single thread at a time: the rings which another thread is consuming are skipped.
+ */
+static void shm_rings_consume(bool discard)
+{
+	size_t rings_cnt = (size_t)n_nodes * global_config.n_threads;
+	size_t first = msg_ring_idx(nid, 0, 0);
+	for(size_t k = 0; k < rings_cnt; ++k) {
+		size_t i = first + (k + rid) % rings_cnt;
+		struct shm_ring *r = &msg_rings[i];
+		if(atomic_load_explicit(&r->tail, memory_order_relaxed) ==
+		    atomic_load_explicit(&r->head, memory_order_relaxed))
+			continue;
+		if(atomic_exchange_explicit(&r->busy, true, memory_order_acquire))
+			continue;
+
+		const unsigned char *buf = msg_bufs + i * SHM_MSG_RING_SIZE;
+		uint64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+		uint64_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+		while(tail != head) {
+			uint32_t h;
+			shm_copy_out(buf, SHM_MSG_RING_SIZE, tail, &h, sizeof(h));
+			tail += sizeof(h);
+
+			if(unlikely(h & SHM_CTRL_FLAG)) {
+				shm_ctrl_msg_process(h & ~SHM_CTRL_FLAG);
+				continue;
+			}
+
+			struct lp_msg *msg;
+			if(h == msg_remote_anti_size()) {
+				msg = msg_allocator_alloc(0);
+				// make sure the deterministic tie-breaking doesn't read uninitialized data
+				msg->m_type = 0;
+				msg->pl_size = 0;
+				shm_copy_out(buf, SHM_MSG_RING_SIZE, tail, msg_remote_data(msg), h);
+				gvt_remote_anti_msg_receive(msg);
+			} else {
+				msg = msg_allocator_alloc(h - offsetof(struct lp_msg, pl) + msg_preamble_size());
+				shm_copy_out(buf, SHM_MSG_RING_SIZE, tail, msg_remote_data(msg), h);
+				gvt_remote_msg_receive(msg);
+			}
+			tail += h;
+
+			if(unlikely(discard))
+				msg_allocator_free(msg);
+			else
+				msg_queue_insert(msg);
+		}
+
+		atomic_store_explicit(&r->tail, tail, memory_order_release);
+		atomic_store_explicit(&r->busy, false, memory_order_release);
+	}
+}
+
+/**
+ * @brief Makes progress on the incoming rings while the current thread waits for the other nodes
+ *
+ * A node waiting for room in the rings directed to this node is stuck until a thread here consumes them, so every wait
+ * loop of this module calls this function. The control messages received meanwhile are deferred to the next polling,
+ * either mpi_remote_msg_handle() or mpi_remote_msg_drain(). A thread which has no messaging state, such as the main
+ * thread during the global finalization, only spins.
+ */
+static void shm_wait_progress(void)
+{
+	if(likely(rcv_active)) {
+		bool nested = rcv_nested;
+		rcv_nested = true;
+		shm_rings_consume(rcv_discard);
+		rcv_nested = nested;
+	}
+	spin_pause();
+}
+
+/**
+ * @brief Writes a record in the ring from the current thread to a node
+ * @param dest the id of the destination node
+ * @param h the header of the record, either the size of @p data or a control message marked with SHM_CTRL_FLAG
+ * @param data the message data of the record, if any
+ * @param size the size in bytes of @p data
+ *
+ * While the ring is full, the current thread consumes its incoming rings, since the threads of the destination node
+ * may in turn be waiting for room in the rings directed to this node.
+ */
+static void shm_msg_ring_push(nid_t dest, uint32_t h, const void *data, uint32_t size)
+{
+	size_t i = msg_ring_idx(dest, nid, rid);
+	struct shm_ring *r = &msg_rings[i];
+	unsigned char *buf = msg_bufs + i * SHM_MSG_RING_SIZE;
+	uint64_t r_size = sizeof(h) + size;
+	if(unlikely(r_size > SHM_MSG_RING_SIZE)) {
+		logger(LOG_FATAL, "A message of %u bytes is too large for the shared memory transport", size);
+		abort();
+	}
+
+	uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+	while(unlikely(head + r_size - atomic_load_explicit(&r->tail, memory_order_acquire) > SHM_MSG_RING_SIZE))
+		shm_wait_progress();
+
+	shm_copy_in(buf, SHM_MSG_RING_SIZE, head, &h, sizeof(h));
+	if(size)
+		shm_copy_in(buf, SHM_MSG_RING_SIZE, head + sizeof(h), data, size);
+	atomic_store_explicit(&r->head, head + r_size, memory_order_release);
+}
+
+/**
+ * @brief Sends a model message to a LP residing on another node
+ * @param msg the message to send
+ * @param dest_nid the id of the node where the targeted LP resides
+ *
+ * This function also calls the relevant handlers in order to keep, for example, the non blocking gvt algorithm running.
+ */
+void mpi_remote_msg_send(struct lp_msg *msg, nid_t dest_nid)
+{
+	gvt_remote_msg_send(msg, dest_nid);
+	shm_msg_ring_push(dest_nid, msg_remote_size(msg), msg_remote_data(msg), msg_remote_size(msg));
+
+	if(unlikely(credit_used != NULL) && ++credit_used[dest_nid] >= global_config.remote_credit)
+		credit_exhausted = true;
+}
+
+/**
+ * @brief Sends a model anti-message to a LP residing on another node
+ * @param msg the message to rollback
+ * @param dest_nid the id of the node where the targeted LP resides
+ *
+ * This function also calls the relevant handlers in order to keep, for example, the non blocking gvt algorithm running.
+ */
+void mpi_remote_anti_msg_send(struct lp_msg *msg, nid_t dest_nid)
+{
+	gvt_remote_anti_msg_send(msg, dest_nid);
+	shm_msg_ring_push(dest_nid, msg_remote_anti_size(), msg_remote_data(msg), msg_remote_anti_size());
+}
+
+/**
+ * @brief Checks if the current thread has to hold back its event processing
+ * @return true if the current thread has used up its credit towards some node since the last GVT, false otherwise
+ */
+bool mpi_remote_msg_throttled(void)
+{
+	return credit_exhausted;
+}
+
+/**
+ * @brief Gives back the remote message credit of the current thread
+ */
+void mpi_remote_msg_on_gvt(void)
+{
+	if(likely(credit_used == NULL))
+		return;
+
+	memset(credit_used, 0, n_nodes * sizeof(*credit_used));
+	credit_exhausted = false;
+}
+
+/**
+ * @brief Sends a platform control message to all the nodes, including self
+ * @param ctrl the control message to send
+ */
+void mpi_control_msg_broadcast(enum msg_ctrl_code ctrl)
+{
+	nid_t i = n_nodes;
+	while(i--)
+		mpi_control_msg_send_to(ctrl, i);
+}
+
+/**
+ * @brief Sends a platform control message to a specific nodes
+ * @param ctrl the control message to send
+ * @param dest the id of the destination node
+ */
+void mpi_control_msg_send_to(enum msg_ctrl_code ctrl, nid_t dest)
+{
+	shm_msg_ring_push(dest, SHM_CTRL_FLAG | ctrl, NULL, 0);
+}
+
+/**
+ * @brief Handles the control messages received while the current thread was waiting for the other nodes
+ */
+static void shm_ctrl_deferred_process(void)
+{
+	if(likely(array_is_empty(ctrl_deferred)))
+		return;
+
+	for(array_count_t i = 0; i < array_count(ctrl_deferred); ++i)
+		control_msg_process(array_get_at(ctrl_deferred, i));
+	array_count(ctrl_deferred) = 0;
+}
+
+/**
+ * @brief Empties the rings directed to this node, doing the right thing for each record
+ *
+ * Control messages are handled by the respective platform handler. Simulation messages are put in the queue.
+ */
+void mpi_remote_msg_handle(void)
+{
+	shm_ctrl_deferred_process();
+	shm_rings_consume(false);
+}
+
+/**
+ * @brief Empties the rings directed to this node, ignoring the simulation messages
+ *
+ * It is used at simulation completion to clear the transport state.
+ */
+void mpi_remote_msg_drain(void)
+{
+	rcv_discard = true;
+	shm_ctrl_deferred_process();
+	shm_rings_consume(true);
+}
+
+/**
+ * @brief Computes the sum-reduction-scatter operation across all nodes.
+ * @param values a flexible array implementing the addendum vector from the calling node.
+ * @param result a pointer where the nid-th component of the sum will be stored.
+ *
+ * The contributions of consecutive operations alternate between two buffers: a node can't start an operation before
+ * the others have collected the result of the previous one, since the GVT algorithm runs a min-reduction in between.
+ */
+void mpi_reduce_sum_scatter(const uint32_t values[n_nodes], uint32_t *result)
+{
+	memcpy(sum_vals + ((sum_round & 1U) * n_nodes + nid) * n_nodes, values, n_nodes * sizeof(*sum_vals));
+	sum_result = result;
+	++sum_round;
+	atomic_fetch_add_explicit(&hdr->sum_arrived, 1U, memory_order_release);
+}
+
+/**
+ * @brief Checks if a previous mpi_reduce_sum_scatter() operation has completed.
+ * @return true if the previous operation has been completed, false otherwise.
+ */
+bool mpi_reduce_sum_scatter_done(void)
+{
+	if(sum_result == NULL)
+		return true;
+
+	if(atomic_load_explicit(&hdr->sum_arrived, memory_order_acquire) < sum_round * n_nodes)
+		return false;
+
+	const uint32_t *vals = sum_vals + ((sum_round - 1) & 1U) * n_nodes * n_nodes;
+	uint32_t r = 0;
+	for(nid_t i = 0; i < n_nodes; ++i)
+		r += vals[i * n_nodes + nid];
+	*sum_result = r;
+	sum_result = NULL;
+	return true;
+}
+
+/**
+ * @brief Computes the min-reduction operation across all nodes.
+ * @param node_min_p a pointer to the value from the calling node which will
+ *                   also be used to store the computed minimum.
+ */
+void mpi_reduce_min(double *node_min_p)
+{
+	min_vals[(min_round & 1U) * n_nodes + nid] = *node_min_p;
+	min_result = node_min_p;
+	++min_round;
+	atomic_fetch_add_explicit(&hdr->min_arrived, 1U, memory_order_release);
+}
+
+/**
+ * @brief Checks if a previous mpi_reduce_min() operation has completed.
+ * @return true if the previous operation has been completed, false otherwise.
+ */
+bool mpi_reduce_min_done(void)
+{
+	if(min_result == NULL)
+		return true;
+
+	if(atomic_load_explicit(&hdr->min_arrived, memory_order_acquire) < min_round * n_nodes)
+		return false;
+
+	const double *vals = min_vals + ((min_round - 1) & 1U) * n_nodes;
+	double r = vals[0];
+	for(nid_t i = 1; i < n_nodes; ++i)
+		r = min(r, vals[i]);
+	*min_result = r;
+	min_result = NULL;
+	return true;
+}
+
+/**
+ * @brief A node barrier
+ *
+ * The incoming rings are consumed while waiting, since the nodes which haven't arrived yet may be sending messages to
+ * this one, for example while initializing their LPs.
+ */
+void mpi_node_barrier(void)
+{
+	++barrier_round;
+	atomic_fetch_add_explicit(&hdr->barrier_arrived, 1U, memory_order_acq_rel);
+	while(atomic_load_explicit(&hdr->barrier_arrived, memory_order_acquire) < barrier_round * n_nodes)
+		shm_wait_progress();
+}
+
+/**
+ * @brief Writes some data in a data ring, waiting for room as needed
+ * @param i the index of the data ring
+ * @param data the data to write
+ * @param size the size in bytes of @p data
+ */
+static void shm_data_write(size_t i, const void *data, size_t size)
+{
+	struct shm_ring *r = &data_rings[i];
+	unsigned char *buf = data_bufs + i * SHM_DATA_RING_SIZE;
+	const unsigned char *d = data;
+	uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+	while(size) {
+		size_t room = SHM_DATA_RING_SIZE - (head - atomic_load_explicit(&r->tail, memory_order_acquire));
+		if(!room) {
+			shm_wait_progress();
+			continue;
+		}
+		size_t c = min(room, size);
+		shm_copy_in(buf, SHM_DATA_RING_SIZE, head, d, c);
+		head += c;
+		d += c;
+		size -= c;
+		atomic_store_explicit(&r->head, head, memory_order_release);
+	}
+}
+
+/**
+ * @brief Reads some data from a data ring, waiting for it as needed
+ * @param i the index of the data ring
+ * @param data where to store the data
+ * @param size the size in bytes of the data to read
+ */
+static void shm_data_read(size_t i, void *data, size_t size)
+{
+	struct shm_ring *r = &data_rings[i];
+	const unsigned char *buf = data_bufs + i * SHM_DATA_RING_SIZE;
+	unsigned char *d = data;
+	uint64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+	while(size) {
+		size_t avail = atomic_load_explicit(&r->head, memory_order_acquire) - tail;
+		if(!avail) {
+			shm_wait_progress();
+			continue;
+		}
+		size_t c = min(avail, size);
+		shm_copy_out(buf, SHM_DATA_RING_SIZE, tail, d, c);
+		tail += c;
+		d += c;
+		size -= c;
+		atomic_store_explicit(&r->tail, tail, memory_order_release);
+	}
+}
+
+/**
+ * @brief Sends a byte buffer to another node
+ * @param data a pointer to the buffer to send
+ * @param data_size the buffer size
+ * @param dest the id of the destination node
+ *
+ * This operation blocks the execution flow until the destination node receives
+ * the data with mpi_blocking_data_rcv().
+ */
+void mpi_blocking_data_send(const void *data, int data_size, nid_t dest)
+{
+	size_t i = data_ring_idx(dest, nid);
+	shm_data_write(i, &data_size, sizeof(data_size));
+	shm_data_write(i, data, data_size);
+}
+
+/**
+ * @brief Receives a byte buffer from another node
+ * @param data_size_p where to write the size of the received data
+ * @param src the id of the sender node
+ * @return the buffer allocated with mm_alloc() containing the received data
+ *
+ * This operation blocks the execution until the sender node actually sends the data with mpi_blocking_data_send().
+ */
+void *mpi_blocking_data_rcv(int *data_size_p, nid_t src)
+{
+	size_t i = data_ring_idx(nid, src);
+	int data_size;
+	shm_data_read(i, &data_size, sizeof(data_size));
+	char *ret = mm_alloc(data_size);
+	shm_data_read(i, ret, data_size);
+	if(data_size_p != NULL)
+		*data_size_p = data_size;
+	return ret;
+}
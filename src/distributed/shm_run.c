@@ -0,0 +1,88 @@
+/**
+ * @file distributed/shm_run.c
+ *
+ * @brief Launcher of the simulations using the shared memory transport
+ *
+ * This program starts a number of processes running the same simulation executable, each one of which acts as a node
+ * of a distributed simulation. The processes find the shared memory segment, the count of nodes and their own node id
+ * in the environment.
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/// The maximum count of processes this launcher can start
+#define SHM_RUN_MAX_PROCS 1024
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s -n <processes> <program> [args...]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+	if(argc < 4 || strcmp(argv[1], "-n")) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	int n = atoi(argv[2]);
+	if(n < 1 || n > SHM_RUN_MAX_PROCS) {
+		fprintf(stderr, "The count of processes must be between 1 and %d\n", SHM_RUN_MAX_PROCS);
+		return EXIT_FAILURE;
+	}
+
+	char name[64], buf[16];
+	snprintf(name, sizeof(name), "/rootsim-shm-%ld", (long)getpid());
+	shm_unlink(name);
+	setenv("ROOTSIM_SHM_NAME", name, 1);
+	snprintf(buf, sizeof(buf), "%d", n);
+	setenv("ROOTSIM_SHM_NODES", buf, 1);
+
+	static pid_t pids[SHM_RUN_MAX_PROCS];
+	int ret = EXIT_SUCCESS;
+	for(int i = 0; i < n; ++i) {
+		snprintf(buf, sizeof(buf), "%d", i);
+		setenv("ROOTSIM_SHM_NID", buf, 1);
+		pids[i] = fork();
+		if(pids[i] == 0) {
+			execvp(argv[3], &argv[3]);
+			perror("Unable to start the simulation");
+			_exit(127);
+		}
+		if(pids[i] == -1) {
+			perror("Unable to fork");
+			for(int j = 0; j < i; ++j)
+				kill(pids[j], SIGTERM);
+			n = i;
+			ret = EXIT_FAILURE;
+			break;
+		}
+	}
+
+	// a node which fails would leave the others waiting forever, so they get terminated
+	for(int alive = n; alive; --alive) {
+		int status;
+		pid_t pid = wait(&status);
+		if(pid == -1)
+			break;
+		if(WIFEXITED(status) && !WEXITSTATUS(status))
+			continue;
+
+		ret = EXIT_FAILURE;
+		for(int i = 0; i < n; ++i)
+			if(pids[i] != pid)
+				kill(pids[i], SIGTERM);
+	}
+
+	shm_unlink(name);
+	return ret;
+}
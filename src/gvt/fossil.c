@@ -46,7 +46,7 @@ void fossil_lp_collect(struct lp_ctx *lp)
 		} while(!is_msg_past(msg));
 	}
 
-	past_i = model_allocator_fossil_lp_collect(&lp->mm_state, past_i + 1);
+	past_i = model_allocator_fossil_lp_collect(&lp_cold(lp)->mm_state, past_i + 1);
 
 	array_count_t k = past_i;
 	while(k--) {
@@ -55,6 +55,4 @@ void fossil_lp_collect(struct lp_ctx *lp)
 			msg_allocator_free(unmark_msg(msg));
 	}
 	array_truncate_first(proc_p->p_msgs, past_i);
-
-	lp->fossil_epoch = fossil_epoch_current;
 }
@@ -178,6 +178,9 @@ static bool gvt_node_phase_run(void)
 				break;
 
 			gvt_phase = gvt_phase ^ (!node_phase);
+			// the remote messages accounted in the closed phase must reach their destination
+			if(node_phase == node_phase_redux_first)
+				mpi_remote_msg_flush();
 			thread_phase = thread_phase_A;
 			++node_phase;
 			break;
@@ -35,7 +35,7 @@ void termination_global_init(void)
  */
 void termination_lp_init(struct lp_ctx *lp)
 {
-	bool term = global_config.committed(lp - lps, lp->state_pointer);
+	bool term = global_config.committed(lp_id_get(lp), lp->state_pointer);
 	lps_to_end += !term;
 	lp->termination_t = term * SIMTIME_MAX;
 }
@@ -49,7 +49,7 @@ void termination_on_msg_process(struct lp_ctx *lp, simtime_t msg_time)
 	if(lp->termination_t)
 		return;
 
-	bool term = global_config.committed(lp - lps, lp->state_pointer);
+	bool term = global_config.committed(lp_id_get(lp), lp->state_pointer);
 	max_t = term ? max(msg_time, max_t) : max_t;
 	lp->termination_t = term * msg_time;
 	lps_to_end -= term;
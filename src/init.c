@@ -38,6 +38,13 @@ static void print_logo(void)
 }
 
 
+/// The human readable names of the checkpointing interval policies
+static const char *const ckpt_policy_names[] = {
+    [CKPT_POLICY_THREAD] = "thread",
+    [CKPT_POLICY_LP] = "per LP",
+    [CKPT_POLICY_MEMORY] = "memory"
+};
+
 /**
  * @brief Pretty prints ROOT-Sim current configuration
  */
@@ -57,12 +64,52 @@ static void print_config(void)
 	if(global_config.serial) {
 		fprintf(stderr, "Parallelism: sequential simulation\n");
 	} else {
-		if(n_nodes > 1)
+		if(n_nodes > 1) {
 			fprintf(stderr, "Parallelism: %d MPI processes\n", n_nodes);
-		else
+			fprintf(stderr, "MPI traffic: %s\n", global_config.mpi_funneled ? "funneled" : "multiple threads");
+			if(global_config.remote_credit)
+				fprintf(stderr, "Remote credit: %u messages per node per GVT\n", global_config.remote_credit);
+			else
+				fprintf(stderr, "Remote credit: unlimited\n");
+		} else {
 			fprintf(stderr, "Parallelism: %u threads\n", global_config.n_threads);
+		}
+	}
+	if(!global_config.serial) {
+		if(global_config.placement_profile != NULL)
+			fprintf(stderr, "LP placement: from the profile %s\n", global_config.placement_profile);
+		else if(global_config.placement_topology != NULL)
+			fprintf(stderr, "LP placement: from the topology\n");
+		else
+			fprintf(stderr, "LP placement: by blocks of ids\n");
 	}
+	if(global_config.comm_prof_period)
+		fprintf(stderr, "LP communication profile: 1 out of %u messages\n", global_config.comm_prof_period);
 	fprintf(stderr, "Thread-to-core binding: %s\n", global_config.core_binding ? "enabled" : "disabled");
+#ifdef ROOTSIM_INCREMENTAL
+	fprintf(stderr, "Write tracking: %s\n", global_config.write_tracking ? "enabled" : "disabled");
+#endif
+	fprintf(stderr, "Huge pages: %s\n", global_config.huge_pages ? "enabled" : "disabled");
+	if(global_config.msg_pool_size || global_config.msg_pool_calibrate) {
+		fprintf(stderr, "Message pools: pre-allocated");
+		if(global_config.msg_pool_size)
+			fprintf(stderr, ", %u messages", global_config.msg_pool_size);
+		if(global_config.msg_pool_calibrate)
+			fprintf(stderr, ", calibrated at the first GVT");
+		fprintf(stderr, "\n");
+	} else {
+		fprintf(stderr, "Message pools: on demand\n");
+	}
+	fprintf(stderr, "Fast teardown: %s\n", global_config.fast_teardown ? "enabled" : "disabled");
+	if(global_config.paging_dir != NULL && !global_config.serial) {
+		if(global_config.paging_policy != NULL)
+			fprintf(stderr, "LP paging: in %s (model policy)\n", global_config.paging_dir);
+		else
+			fprintf(stderr, "LP paging: in %s after %u idle GVT phases\n", global_config.paging_dir,
+			    global_config.paging_idle_gvts);
+	} else {
+		fprintf(stderr, "LP paging: disabled\n");
+	}
 
 	fprintf(stderr, "GVT period: %u ms\n", global_config.gvt_period / 1000);
 
@@ -70,7 +117,7 @@ static void print_config(void)
 		fprintf(stderr, "Checkpoint interval: %u events\n", global_config.ckpt_interval);
 	} else {
 		if(!global_config.serial)
-			fprintf(stderr, "Checkpoint interval: auto\n");
+			fprintf(stderr, "Checkpoint interval: auto (%s policy)\n", ckpt_policy_names[global_config.ckpt_policy]);
 	}
 
 	fprintf(stderr, "\x1b[39m");
@@ -102,6 +149,18 @@ int RootsimInit(const struct simulation_configuration *conf)
 		return -1;
 	}
 
+#ifdef ROOTSIM_COMPACT_MSG
+	if(unlikely(global_config.lps > UINT32_MAX)) {
+		fprintf(stderr, "The compact messages support at most %" PRIu32 " Logical Processes\n", UINT32_MAX);
+		return -1;
+	}
+#endif
+
+	if(unlikely(global_config.ckpt_policy > CKPT_POLICY_MEMORY)) {
+		fprintf(stderr, "Unknown checkpointing interval policy\n");
+		return -1;
+	}
+
 	if(unlikely(global_config.n_threads > thread_cores_count())) {
 		fprintf(stderr, "Demanding %u cores, which are more than available (%u)\n", global_config.n_threads,
 		    thread_cores_count());
@@ -118,6 +177,9 @@ int RootsimInit(const struct simulation_configuration *conf)
 	if(global_config.termination_time == 0)
 		global_config.termination_time = SIMTIME_MAX;
 
+	if(global_config.paging_idle_gvts == 0)
+		global_config.paging_idle_gvts = 16;
+
 	configuration_done = true;
 
 	return 0;
@@ -13,6 +13,7 @@
 
 #include <core/core.h>
 #include <datatypes/list.h>
+#include <lib/topology/topology.h>
 
 #include <ROOT-Sim.h>
 
@@ -453,6 +454,68 @@ lp_id_t CountDirections(lp_id_t from, struct topology *topology)
 }
 
 
+/**
+ * @brief Get the regions linked to a region, along with the weights of the links
+ * @param topology the topology currently being considered
+ * @param from the source region
+ * @param links where to store the linked regions, with room for max(CountDirections(), DIRECTION_RANDOM) elements
+ * @param weights where to store the weights of the links, with room as much as @p links
+ * @return the count of links stored in @p links and @p weights
+ *
+ * The weight of a link of a TOPOLOGY_GRAPH is the probability to traverse it, 1.0 for the other geometries. A
+ * TOPOLOGY_FCMESH has no locality to speak of, so no link is returned at all for it.
+ */
+lp_id_t topology_links_get(struct topology *topology, lp_id_t from, lp_id_t links[], double weights[])
+{
+	lp_id_t n = 0;
+	struct graph_node *adj_node;
+
+	switch(topology->geometry) {
+		case TOPOLOGY_HEXAGON:
+		case TOPOLOGY_TORUS:
+		case TOPOLOGY_SQUARE:
+		case TOPOLOGY_BIDRING:
+		case TOPOLOGY_RING:
+			for(unsigned i = 0; i < DIRECTION_RANDOM; i++) {
+				lp_id_t to = GetReceiver(from, topology, i);
+				if(to == INVALID_DIRECTION)
+					continue;
+				weights[n] = 1.0;
+				links[n++] = to;
+			}
+			break;
+
+		case TOPOLOGY_STAR:
+			if(from != 0) {
+				weights[n] = 1.0;
+				links[n++] = 0;
+				break;
+			}
+			for(lp_id_t i = 1; i < topology->regions; i++) {
+				weights[n] = 1.0;
+				links[n++] = i;
+			}
+			break;
+
+		case TOPOLOGY_FCMESH:
+			break;
+
+		case TOPOLOGY_GRAPH:
+			assert(topology->adjacency != NULL);
+			if(list_size(topology->adjacency[from]) == 0)
+				break;
+			adj_node = list_head(topology->adjacency[from]);
+			while(adj_node) {
+				weights[n] = adj_node->probability;
+				links[n++] = adj_node->neighbor;
+				adj_node = list_next(adj_node);
+			}
+			break;
+	}
+
+	return n;
+}
+
 bool IsNeighbor(lp_id_t from, lp_id_t to, struct topology *topology)
 {
 	struct graph_node *adj_node;
@@ -0,0 +1,15 @@
+/**
+ * @file lib/topology/topology.h
+ *
+ * @brief Topology library
+ *
+ * The internal facilities of the topology library, used by the core modules
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#pragma once
+
+#include <ROOT-Sim.h>
+
+extern lp_id_t topology_links_get(struct topology *topology, lp_id_t from, lp_id_t links[], double weights[]);
@@ -0,0 +1,199 @@
+/**
+ * @file log/comm_prof.c
+ *
+ * @brief LP communication profiling
+ *
+ * Each thread samples one out of @a comm_prof_period of the messages sent by its LPs, accounting the pair of sender
+ * and receiver LPs. At the end of the run, the samples of all the threads and nodes are merged and written, in text
+ * form, in the <stats_file>_comm.txt file. Every line of the file but the comments, which start with a '#', holds the
+ * id of the sender LP, the id of the receiver LP and the count of sampled messages between them.
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <log/comm_prof.h>
+
+#include <datatypes/array.h>
+#include <distributed/mpi.h>
+#include <log/file.h>
+#include <mm/mm.h>
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// The count of samples a thread collects before compacting them for the first time
+#define COMM_PROF_COMPACT_MIN 4096U
+/// The maximum count of samples sent at once to the master node
+#define COMM_PROF_CHUNK (1U << 20U)
+
+/// The samples collected by each thread, indexed by the thread id
+static dyn_array(struct comm_edge) *comm_threads;
+/// The count of messages the current thread has to send before taking a sample, 0 if the sampling is disabled
+__thread unsigned comm_prof_left;
+/// The count of samples of the current thread right after their last compaction
+static __thread array_count_t comm_compacted;
+
+/**
+ * @brief Compare two communication edges by sender and receiver, for qsort()
+ */
+static int comm_edge_cmp(const void *a, const void *b)
+{
+	const struct comm_edge *ea = a, *eb = b;
+	if(ea->from != eb->from)
+		return ea->from < eb->from ? -1 : 1;
+	if(ea->to != eb->to)
+		return ea->to < eb->to ? -1 : 1;
+	return 0;
+}
+
+/**
+ * @brief Sort a set of communication edges, merging the ones with the same sender and receiver
+ * @param edges the edges to compact
+ * @param cnt the count of edges in @p edges
+ * @return the count of edges left in @p edges
+ */
+uint64_t comm_edges_compact(struct comm_edge *edges, uint64_t cnt)
+{
+	if(!cnt)
+		return 0;
+
+	qsort(edges, cnt, sizeof(*edges), comm_edge_cmp);
+	uint64_t j = 0;
+	for(uint64_t i = 1; i < cnt; ++i) {
+		if(edges[i].from == edges[j].from && edges[i].to == edges[j].to)
+			edges[j].cnt += edges[i].cnt;
+		else
+			edges[++j] = edges[i];
+	}
+	return j + 1;
+}
+
+/**
+ * @brief Initialize the communication profiling in the node
+ */
+void comm_prof_global_init(void)
+{
+	if(likely(!global_config.comm_prof_period))
+		return;
+
+	if(unlikely(global_config.stats_file == NULL)) {
+		logger(LOG_WARN, "No statistics file has been set, the LP communication won't be profiled");
+		global_config.comm_prof_period = 0;
+		return;
+	}
+
+	comm_threads = mm_alloc(global_config.n_threads * sizeof(*comm_threads));
+}
+
+/**
+ * @brief Initialize the communication profiling in the current thread
+ */
+void comm_prof_init(void)
+{
+	comm_prof_left = global_config.comm_prof_period;
+	if(likely(!comm_prof_left))
+		return;
+
+	array_init(comm_threads[rid]);
+	comm_compacted = 0;
+}
+
+/**
+ * @brief Account a sampled message sent from an LP to another one
+ * @param from the id of the sender LP
+ * @param to the id of the receiver LP
+ *
+ * The samples are compacted whenever they double in count, so that the memory used is proportional to the count of
+ * communicating LP pairs rather than to the count of messages.
+ */
+void comm_prof_take(lp_id_t from, lp_id_t to)
+{
+	comm_prof_left = global_config.comm_prof_period;
+
+	struct comm_edge e = {.from = from, .to = to, .cnt = 1};
+	array_push(comm_threads[rid], e);
+	if(array_count(comm_threads[rid]) < max(2 * comm_compacted, COMM_PROF_COMPACT_MIN))
+		return;
+
+	array_count(comm_threads[rid]) = comm_edges_compact(array_items(comm_threads[rid]), array_count(comm_threads[rid]));
+	comm_compacted = array_count(comm_threads[rid]);
+}
+
+/**
+ * @brief Finalize the communication profiling in the current thread
+ */
+void comm_prof_fini(void)
+{
+	if(likely(!global_config.comm_prof_period))
+		return;
+
+	comm_prof_left = 0;
+	array_count(comm_threads[rid]) = comm_edges_compact(array_items(comm_threads[rid]), array_count(comm_threads[rid]));
+}
+
+/**
+ * @brief Write the merged communication profile
+ * @param edges the compacted samples of all the nodes
+ * @param cnt the count of edges in @p edges
+ */
+static void comm_prof_file_write(const struct comm_edge *edges, uint64_t cnt)
+{
+	FILE *o = file_open("w", "%s_comm.txt", global_config.stats_file);
+	if(unlikely(o == NULL)) {
+		logger(LOG_WARN, "Unable to open the LP communication file for writing, the profile won't be saved.");
+		return;
+	}
+
+	fprintf(o, "# ROOT-Sim LP communication profile: %" PRIu64 " LPs, 1 out of %u messages sampled\n",
+	    global_config.lps, global_config.comm_prof_period);
+	for(uint64_t i = 0; i < cnt; ++i)
+		fprintf(o, "%" PRIu64 " %" PRIu64 " %" PRIu64 "\n", edges[i].from, edges[i].to, edges[i].cnt);
+	fclose(o);
+}
+
+/**
+ * @brief Finalize the communication profiling in the node
+ *
+ * The master node collects the samples of the other nodes and writes the profile file.
+ */
+void comm_prof_global_fini(void)
+{
+	if(likely(!global_config.comm_prof_period))
+		return;
+
+	__typeof__(*comm_threads) all = comm_threads[0];
+	for(rid_t i = 1; i < global_config.n_threads; ++i) {
+		array_reserve(all, array_count(comm_threads[i]));
+		memcpy(array_items(all) + array_count(all), array_items(comm_threads[i]),
+		    array_count(comm_threads[i]) * sizeof(*array_items(all)));
+		array_count(all) += array_count(comm_threads[i]);
+		array_fini(comm_threads[i]);
+	}
+	mm_free(comm_threads);
+
+	if(nid) {
+		uint64_t cnt = comm_edges_compact(array_items(all), array_count(all));
+		mpi_blocking_data_send(&cnt, sizeof(cnt), 0);
+		for(uint64_t i = 0; i < cnt; i += COMM_PROF_CHUNK)
+			mpi_blocking_data_send(array_items(all) + i, min(cnt - i, COMM_PROF_CHUNK) * sizeof(*array_items(all)), 0);
+	} else {
+		for(nid_t j = 1; j < n_nodes; ++j) {
+			uint64_t *cnt_p = mpi_blocking_data_rcv(NULL, j);
+			uint64_t cnt = *cnt_p;
+			mm_free(cnt_p);
+
+			array_reserve(all, cnt);
+			for(uint64_t i = 0; i < cnt; i += COMM_PROF_CHUNK) {
+				int size;
+				void *buf = mpi_blocking_data_rcv(&size, j);
+				memcpy(array_items(all) + array_count(all), buf, size);
+				array_count(all) += size / sizeof(*array_items(all));
+				mm_free(buf);
+			}
+		}
+		comm_prof_file_write(array_items(all), comm_edges_compact(array_items(all), array_count(all)));
+	}
+
+	array_fini(all);
+}
@@ -0,0 +1,45 @@
+/**
+ * @file log/comm_prof.h
+ *
+ * @brief LP communication profiling
+ *
+ * Sampling of the messages exchanged by the LPs, which is dumped along with the statistics and can be used to compute
+ * a placement of the LPs in later runs.
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#pragma once
+
+#include <core/core.h>
+
+/// The count of sampled messages sent from an LP to another one
+struct comm_edge {
+	/// The id of the sender LP
+	lp_id_t from;
+	/// The id of the receiver LP
+	lp_id_t to;
+	/// The count of sampled messages
+	uint64_t cnt;
+};
+
+extern __thread unsigned comm_prof_left;
+
+extern void comm_prof_global_init(void);
+extern void comm_prof_global_fini(void);
+extern void comm_prof_init(void);
+extern void comm_prof_fini(void);
+
+extern void comm_prof_take(lp_id_t from, lp_id_t to);
+extern uint64_t comm_edges_compact(struct comm_edge *edges, uint64_t cnt);
+
+/**
+ * @brief Account a message sent from an LP to another one, if it falls in the sample
+ * @param from the id of the sender LP
+ * @param to the id of the receiver LP
+ */
+static inline void comm_prof_sample(lp_id_t from, lp_id_t to)
+{
+	if(unlikely(comm_prof_left) && !--comm_prof_left)
+		comm_prof_take(from, to);
+}
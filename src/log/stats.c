@@ -54,6 +54,8 @@ static_assert(sizeof(struct stats_thread) == 8 * STATS_COUNT && sizeof(struct st
 		  sizeof(struct stats_global) == 24 + 8 * (STATS_GLOBAL_COUNT),
     "structs aren't properly packed, parsing may be difficult");
 
+static_assert(MSG_SIZE_CLASSES == 6, "the names of the message pool statistics don't match the size classes");
+
 /// The statistics names, used to fill in the preamble of the final statistics binary file
 const char *const stats_names[] = {
     [STATS_MSG_PROCESSED] = "processed messages",
@@ -67,6 +69,34 @@ const char *const stats_names[] = {
     [STATS_MSG_SILENT] = "silent messages",
     [STATS_MSG_SILENT_TIME] = "silent messages time",
     [STATS_MSG_ANTI] = "anti messages",
+    [STATS_CKPT_INTERVAL] = "checkpoint interval",
+    [STATS_CKPT_COST_PREDICTED] = "checkpoint predicted cost",
+    [STATS_CKPT_COST_OBSERVED] = "checkpoint observed cost",
+    [STATS_CKPT_DEDUP_LOOKUPS] = "checkpoint dedup lookups",
+    [STATS_CKPT_DEDUP_HITS] = "checkpoint dedup hits",
+    [STATS_CKPT_DEDUP_SAVED] = "checkpoint dedup saved bytes",
+    [STATS_LP_PAGE_OUT] = "LP page outs",
+    [STATS_LP_PAGE_OUT_SIZE] = "LP page outs size",
+    [STATS_LP_PAGE_IN] = "LP page ins",
+    [STATS_MSG_POOL_HIT + 0] = "message pool hits class 0",
+    [STATS_MSG_POOL_HIT + 1] = "message pool hits class 1",
+    [STATS_MSG_POOL_HIT + 2] = "message pool hits class 2",
+    [STATS_MSG_POOL_HIT + 3] = "message pool hits class 3",
+    [STATS_MSG_POOL_HIT + 4] = "message pool hits class 4",
+    [STATS_MSG_POOL_HIT + 5] = "message pool hits class 5",
+    [STATS_MSG_POOL_MISS + 0] = "message pool misses class 0",
+    [STATS_MSG_POOL_MISS + 1] = "message pool misses class 1",
+    [STATS_MSG_POOL_MISS + 2] = "message pool misses class 2",
+    [STATS_MSG_POOL_MISS + 3] = "message pool misses class 3",
+    [STATS_MSG_POOL_MISS + 4] = "message pool misses class 4",
+    [STATS_MSG_POOL_MISS + 5] = "message pool misses class 5",
+    [STATS_MSG_UNPOOLED] = "unpooled messages",
+    [STATS_MSG_RETURNED] = "messages returned to owner",
+    [STATS_MSG_RECLAIMED] = "messages reclaimed from other threads",
+    [STATS_MSG_POOL_TRIMMED] = "pooled messages trimmed",
+    [STATS_MSG_POOL_SIZE] = "pooled messages",
+    [STATS_REMOTE_CREDIT_STALL] = "remote credit stalls",
+    [STATS_PAGE_FAULTS] = "page faults",
     [STATS_REAL_TIME_GVT] = "gvt real time"
 };
 
@@ -82,6 +112,8 @@ static FILE *stats_node_tmp;
 static FILE **stats_tmps;
 /// The current values of thread statistics for this logical time period (from the previous GVT to the next one)
 static __thread struct stats_thread stats_cur;
+/// The count of page faults triggered by this thread up to the previous GVT
+static __thread uint64_t stats_last_faults;
 
 /**
  * @brief Take a lifetime event time value
@@ -100,6 +132,10 @@ void stats_global_init(void)
 	sim_start_ts = timer_new();
 	sim_start_ts_hr = timer_hr_new();
 
+	// the resident set size is also used by the memory aware checkpointing policy
+	if(mem_stat_setup() < 0)
+		logger(LOG_ERROR, "Unable to extract memory statistics!");
+
 	if(global_config.stats_file == NULL)
 		return;
 
@@ -111,9 +147,6 @@ void stats_global_init(void)
 	}
 
 	setvbuf(stats_node_tmp, NULL, _IOFBF, STATS_BUFFER_ENTRIES * sizeof(struct stats_node));
-
-	if(mem_stat_setup() < 0)
-		logger(LOG_ERROR, "Unable to extract memory statistics!");
 	stats_tmps = mm_alloc(global_config.n_threads * sizeof(*stats_tmps));
 }
 
@@ -133,6 +166,7 @@ void stats_init(void)
 	}
 
 	setvbuf(stats_tmps[rid], NULL, _IOFBF, STATS_BUFFER_ENTRIES * sizeof(stats_cur));
+	stats_last_faults = mem_stat_page_faults_get();
 }
 
 /**
@@ -354,6 +388,10 @@ void stats_on_gvt(simtime_t gvt)
 
 	stats_cur.s[STATS_REAL_TIME_GVT] = timer_value(sim_start_ts);
 
+	uint64_t faults = mem_stat_page_faults_get();
+	stats_cur.s[STATS_PAGE_FAULTS] = faults - stats_last_faults;
+	stats_last_faults = faults;
+
 	file_write_chunk(stats_tmps[rid], &stats_cur, sizeof(stats_cur));
 	memset(&stats_cur, 0, sizeof(stats_cur));
 
@@ -377,6 +415,8 @@ void stats_dump(void)
 		}
 		double t = (double)timer_value(sim_start_ts) / 1000000.0;
 		logger(LOG_INFO, "Simulation completed in %.3lf seconds", t);
+		double rss = (double)mem_stat_rss_max_get() / (1024.0 * 1024.0);
+		logger(LOG_INFO, "Peak resident set size: %.3lf MB", rss);
 	}
 }
 
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <core/core.h>
+#include <lp/msg.h>
 
 /// The kind of timestamps collected during the simulation execution lifetime
 enum stats_global_type {
@@ -55,6 +56,46 @@ enum stats_thread_type {
 	STATS_MSG_SILENT_TIME,
 	/// The count of generated anti-messages
 	STATS_MSG_ANTI,
+	/// The checkpointing interval averaged over the LPs of the thread, sampled at GVT
+	STATS_CKPT_INTERVAL,
+	/// The checkpointing and silent execution time predicted by the interval selection policy
+	STATS_CKPT_COST_PREDICTED,
+	/// The checkpointing and silent execution time actually observed over the same events of the prediction
+	STATS_CKPT_COST_OBSERVED,
+	/// The count of checkpointed blocks looked up in the deduplication store
+	STATS_CKPT_DEDUP_LOOKUPS,
+	/// The count of checkpointed blocks found already in the deduplication store
+	STATS_CKPT_DEDUP_HITS,
+	/// The size in bytes of the checkpointed blocks which the deduplication store didn't have to copy
+	STATS_CKPT_DEDUP_SAVED,
+	/// The count of LPs paged out to the paging file
+	STATS_LP_PAGE_OUT,
+	/// The size in bytes of the memory paged out to the paging file
+	STATS_LP_PAGE_OUT_SIZE,
+	/// The count of LPs paged back in from the paging file
+	STATS_LP_PAGE_IN,
+	/// The count of messages taken from the pools of the thread, one entry for each size class
+	STATS_MSG_POOL_HIT,
+	/// The last entry of the counts of messages taken from the pools of the thread
+	STATS_MSG_POOL_HIT_LAST = STATS_MSG_POOL_HIT + MSG_SIZE_CLASSES - 1,
+	/// The count of messages which had to be allocated since the pool was empty, one entry for each size class
+	STATS_MSG_POOL_MISS,
+	/// The last entry of the counts of messages which had to be allocated since the pool was empty
+	STATS_MSG_POOL_MISS_LAST = STATS_MSG_POOL_MISS + MSG_SIZE_CLASSES - 1,
+	/// The count of messages whose payload is too large to be pooled
+	STATS_MSG_UNPOOLED,
+	/// The count of freed messages returned to the threads which allocated them
+	STATS_MSG_RETURNED,
+	/// The count of messages returned by other threads and put back in the pool of the thread
+	STATS_MSG_RECLAIMED,
+	/// The count of pooled messages released since they weren't needed in the last GVT phase
+	STATS_MSG_POOL_TRIMMED,
+	/// The count of pooled messages, sampled at GVT
+	STATS_MSG_POOL_SIZE,
+	/// The count of processing rounds skipped since the thread had used up its remote message credit
+	STATS_REMOTE_CREDIT_STALL,
+	/// The count of page faults triggered by the thread
+	STATS_PAGE_FAULTS,
 	/// The real time elapsed since last GVT computation
 	STATS_REAL_TIME_GVT, // used internally, don't use elsewhere
 	/// Used to count the members of this enum
@@ -13,18 +13,22 @@
 #include <datatypes/msg_queue.h>
 #include <core/sync.h>
 #include <gvt/termination.h>
+#include <mm/paging.h>
 
-/// The lowest LP id between the ones hosted on this node
+/// The lowest LP id between the ones hosted on this node, 0 if the LPs are placed through #placement_lps
 uint64_t lid_node_first;
-/// The lowest LP id between the ones hosted on this thread
+/// The position of the first LP hosted on this thread, see #lid_thread_at()
 __thread uint64_t lid_thread_first;
-/// One plus the highest LP id between the ones hosted on this thread
+/// One plus the position of the last LP hosted on this thread, see #lid_thread_at()
 __thread uint64_t lid_thread_end;
 /// A pointer to the currently processed LP context
 __thread struct lp_ctx *current_lp;
 /// A pointer to the LP contexts array
-/** Valid entries are contained between #lid_node_first and #lid_node_first + #n_lps_node - 1, limits included */
+/** Valid entries are contained between #lid_node_first and #lid_node_first + #n_lps_node - 1, limits included. They are
+ * indexed by the LP position in the sequences of #lid_thread_at(), see #lid_to_lp() and #lp_id_get() */
 struct lp_ctx *lps;
+/// A pointer to the LP cold contexts array, indexed as #lps
+struct lp_cold_ctx *lps_cold;
 /// The number of LPs hosted on this node
 lp_id_t n_lps_node;
 
@@ -59,11 +63,19 @@ bool lp_initialized;
  */
 void lp_global_init(void)
 {
-	lid_node_first = partition_start(nid, n_nodes, lid_to_nid, 0, global_config.lps);
-	n_lps_node = partition_start(nid + 1, n_nodes, lid_to_nid, 0, global_config.lps) - lid_node_first;
+	if(unlikely(placement_order != NULL)) {
+		// the LPs of this node are scattered among all the ids, so their contexts are indexed by their position
+		lid_node_first = 0;
+		n_lps_node = placement_thread_first[global_config.n_threads];
+	} else {
+		lid_node_first = partition_start(nid, n_nodes, lid_to_nid, 0, global_config.lps);
+		n_lps_node = partition_start(nid + 1, n_nodes, lid_to_nid, 0, global_config.lps) - lid_node_first;
+	}
 
-	lps = mm_alloc(sizeof(*lps) * n_lps_node);
+	lps = mm_aligned_alloc(CACHE_LINE_SIZE, sizeof(*lps) * n_lps_node);
 	lps -= lid_node_first;
+	lps_cold = mm_alloc(sizeof(*lps_cold) * n_lps_node);
+	lps_cold -= lid_node_first;
 
 	if(n_lps_node < global_config.n_threads) {
 		logger(LOG_WARN, "The simulation will run with %u threads instead of the requested %u", n_lps_node,
@@ -78,7 +90,9 @@ void lp_global_init(void)
 void lp_global_fini(void)
 {
 	lps += lid_node_first;
-	mm_free(lps);
+	mm_aligned_free(lps);
+	lps_cold += lid_node_first;
+	mm_free(lps_cold);
 }
 
 /**
@@ -86,21 +100,28 @@ void lp_global_fini(void)
  */
 void lp_init(void)
 {
-	lid_thread_first = partition_start(rid, global_config.n_threads, lid_to_rid, lid_node_first, n_lps_node);
-	lid_thread_end = partition_start(rid + 1, global_config.n_threads, lid_to_rid, lid_node_first, n_lps_node);
+	if(unlikely(placement_order != NULL)) {
+		lid_thread_first = placement_thread_first[rid];
+		lid_thread_end = placement_thread_first[rid + 1];
+	} else {
+		lid_thread_first = partition_start(rid, global_config.n_threads, lid_to_rid, lid_node_first, n_lps_node);
+		lid_thread_end = partition_start(rid + 1, global_config.n_threads, lid_to_rid, lid_node_first, n_lps_node);
+	}
 
-	for(uint64_t i = lid_thread_first; i < lid_thread_end; ++i) {
-		struct lp_ctx *lp = &lps[i];
+	for(uint64_t k = lid_thread_first; k < lid_thread_end; ++k) {
+		struct lp_ctx *lp = &lps[k];
+		struct lp_cold_ctx *lp_c = &lps_cold[k];
 
-		model_allocator_lp_init(&lp->mm_state);
+		model_allocator_lp_init(&lp_c->mm_state);
 		lp->state_pointer = NULL;
 		lp->fossil_epoch = 0;
+		lp_c->paged = false;
 
 		current_lp = lp;
 		lp->rng_ctx = rs_malloc(sizeof(*lp->rng_ctx));
-		random_lib_lp_init(i, lp->rng_ctx);
+		random_lib_lp_init(lid_thread_at(k), lp->rng_ctx);
 
-		auto_ckpt_lp_init(&lp->auto_ckpt);
+		auto_ckpt_lp_init(&lp->auto_ckpt, &lp_c->auto_ckpt_prof);
 		process_lp_init(lp);
 		termination_lp_init(lp);
 	}
@@ -108,16 +129,23 @@ void lp_init(void)
 
 /**
  * @brief Finalize the data structures of the LPs hosted in the calling thread
+ *
+ * With a fast teardown, the models still receive the LP_FINI event, but the memory of the LPs is dropped in bulk.
  */
 void lp_fini(void)
 {
-	for(uint64_t i = lid_thread_first; i < lid_thread_end; ++i) {
-		struct lp_ctx *lp = &lps[i];
+	for(uint64_t k = lid_thread_first; k < lid_thread_end; ++k) {
+		struct lp_ctx *lp = &lps[k];
 
+		paging_lp_ensure(lp);
 		process_lp_fini(lp);
-		model_allocator_lp_fini(&lp->mm_state);
+		if(!global_config.fast_teardown)
+			model_allocator_lp_fini(&lps_cold[k].mm_state);
 	}
 
+	if(global_config.fast_teardown)
+		model_allocator_thread_drop();
+
 	current_lp = NULL;
 }
 
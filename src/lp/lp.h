@@ -14,34 +14,58 @@
 #include <core/core.h>
 #include <lib/random/random.h>
 #include <lp/msg.h>
+#include <lp/placement.h>
 #include <lp/process.h>
 #include <mm/auto_ckpt.h>
 #include <mm/model_allocator.h>
 
-/// A complete LP context
+#include <stdalign.h>
+
+/// The context of an LP accessed while processing any message, which fits in a single cache line
 struct lp_ctx {
-	/// The termination time of this LP, handled by the termination module
-	simtime_t termination_t;
-	/// The additional libraries context of this LP
-	struct rng_ctx *rng_ctx;
+	/// The message processing context of this LP
+	alignas(CACHE_LINE_SIZE) struct process_ctx p;
 	/// The pointer set by the model with the SetState() API call
 	void *state_pointer;
-	/// The housekeeping epoch number
-	unsigned fossil_epoch;
-	/// The automatic checkpointing interval selection data
+	/// The additional libraries context of this LP
+	struct rng_ctx *rng_ctx;
+	/// The termination time of this LP, handled by the termination module
+	simtime_t termination_t;
+	/// The automatic checkpointing interval selection counters
 	struct auto_ckpt auto_ckpt;
-	/// The message processing context of this LP
-	struct process_ctx p;
+	/// The housekeeping epoch in which this LP last processed a message
+	unsigned fossil_epoch;
+};
+
+static_assert(sizeof(struct lp_ctx) == CACHE_LINE_SIZE, "the LP context spans several cache lines");
+
+/// The context of an LP accessed only on rollbacks, checkpoints and housekeeping, kept apart from @a lp_ctx
+struct lp_cold_ctx {
 	/// The memory allocator state of this LP
 	struct mm_state mm_state;
+	/// The automatic checkpointing interval selection profiling data
+	struct auto_ckpt_prof auto_ckpt_prof;
+	/// The list of remote anti-messages delivered before their original counterpart
+	/** Hopefully this is 99.9% of the time empty */
+	struct lp_msg *early_antis;
+	/// Set if the memory of this LP has been moved to the paging file of its thread
+	bool paged;
 };
 
+/**
+ * @brief Get the cold context of an LP
+ * @param lp a pointer to the context of the LP
+ * @return a pointer to the cold context of the LP pointed by @p lp
+ */
+#define lp_cold(lp) (&lps_cold[(lp) - lps])
+
 /**
  * @brief Compute the id of the node which hosts a given LP
  * @param lp_id the id of the LP
  * @return the id of the node which hosts the LP identified by @p lp_id
  */
-#define lid_to_nid(lp_id) ((nid_t)((lp_id) * n_nodes / global_config.lps))
+#define lid_to_nid(lp_id)                                                                                              \
+	(unlikely(placement_lps != NULL) ? placement_lps[lp_id].nid : (nid_t)((lp_id) * n_nodes / global_config.lps))
 
 /**
  * @brief Compute the id of the thread which hosts a given LP
@@ -50,7 +74,32 @@ struct lp_ctx {
  *
  * Horrible things may happen if @p lp_id is not locally hosted (use #lid_to_nid() to make sure of that!)
  */
-#define lid_to_rid(lp_id) ((rid_t)(((lp_id) - lid_node_first) * global_config.n_threads / n_lps_node))
+#define lid_to_rid(lp_id)                                                                                              \
+	(unlikely(placement_lps != NULL) ? placement_lps[lp_id].rid                                                    \
+	    : (rid_t)(((lp_id) - lid_node_first) * global_config.n_threads / n_lps_node))
+
+/**
+ * @brief Get the id of an LP hosted in the calling thread
+ * @param i a position between #lid_thread_first and #lid_thread_end
+ * @return the id of the LP at position @p i in the sequence of the LPs hosted in the calling thread
+ *
+ * The context of the LP at position @p i is the one at the same index in #lps.
+ */
+#define lid_thread_at(i) (unlikely(placement_order != NULL) ? placement_order[i] : (lp_id_t)(i))
+
+/**
+ * @brief Get the context of an LP hosted on this node
+ * @param lp_id the id of the LP
+ * @return a pointer to the context of the LP identified by @p lp_id
+ */
+#define lid_to_lp(lp_id) (&lps[unlikely(placement_lps != NULL) ? placement_lps[lp_id].idx : (lp_id)])
+
+/**
+ * @brief Get the id of an LP hosted on this node
+ * @param lp a pointer to the context of the LP
+ * @return the id of the LP whose context is pointed by @p lp
+ */
+#define lp_id_get(lp) lid_thread_at((lp) - lps)
 
 extern uint64_t lid_node_first;
 extern __thread uint64_t lid_thread_first;
@@ -58,6 +107,7 @@ extern __thread uint64_t lid_thread_end;
 
 extern __thread struct lp_ctx *current_lp;
 extern struct lp_ctx *lps;
+extern struct lp_cold_ctx *lps_cold;
 
 #ifndef NDEBUG
 extern bool lp_initialized;
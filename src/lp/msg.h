@@ -12,13 +12,24 @@
 
 #include <core/core.h>
 
+#include <assert.h>
 #include <limits.h>
+#include <stdalign.h>
 #include <stdatomic.h>
 #include <stddef.h>
 #include <string.h>
 
+#ifdef ROOTSIM_MSG_PAYLOAD_BASE_SIZE
+#define MSG_PAYLOAD_BASE_SIZE ROOTSIM_MSG_PAYLOAD_BASE_SIZE
+#elif defined(ROOTSIM_COMPACT_MSG)
+#define MSG_PAYLOAD_BASE_SIZE 24
+#else
 /// The minimum size of the payload to which message allocations are snapped to
 #define MSG_PAYLOAD_BASE_SIZE 32
+#endif
+
+/// The count of pooled message size classes, each doubling the payload size of the previous one
+#define MSG_SIZE_CLASSES 6
 
 /**
  * @brief Compute the value of the happens-before relation between two messages
@@ -55,10 +66,52 @@
  */
 #define msg_remote_anti_size() (offsetof(struct lp_msg, m_seq) - msg_preamble_size() + sizeof(uint32_t))
 
+#ifdef ROOTSIM_COMPACT_MSG
+
+/// A model simulation message, with a compact header: the receiver recomputes lp_msg.pl_size from the wire size
+struct lp_msg {
+	/// The next element in the message list (used in the message queue)
+	struct lp_msg *next;
+	/// The thread which allocated this message, to which it is returned once freed
+	uint16_t owner;
+	/// The message payload size
+	uint16_t pl_size;
+	/// The id of the recipient LP
+	uint32_t dest;
+	/// The intended destination logical time of this message
+	simtime_t dest_t;
+	union {
+		/// The flags to handle local anti messages
+		_Atomic uint32_t flags;
+		/// The message unique id, used for inter-node anti messages
+		uint32_t raw_flags;
+	};
+#ifndef NDEBUG
+	/// The sender of the message
+	uint32_t send;
+	/// The send time of the message
+	simtime_t send_t;
+#endif
+	/// The message sequence number
+	uint32_t m_seq;
+	/// The message type, a user controlled field
+	uint16_t m_type;
+	/// The initial part of the payload
+	alignas(sizeof(simtime_t)) unsigned char pl[MSG_PAYLOAD_BASE_SIZE];
+	/// The continuation of the payload
+	unsigned char extra_pl[];
+};
+
+static_assert(MAX_THREADS <= UINT16_MAX + 1, "the message owner field is too narrow");
+
+#else
+
 /// A model simulation message
 struct lp_msg {
 	/// The next element in the message list (used in the message queue)
 	struct lp_msg *next;
+	/// The thread which allocated this message, to which it is returned once freed
+	rid_t owner;
 	/// The id of the recipient LP
 	lp_id_t dest;
 	/// The intended destination logical time of this message
@@ -87,6 +140,8 @@ struct lp_msg {
 	unsigned char extra_pl[];
 };
 
+#endif
+
 enum msg_flag { MSG_FLAG_ANTI = 1, MSG_FLAG_PROCESSED = 2 };
 
 /**
@@ -0,0 +1,669 @@
+/**
+ * @file lp/placement.c
+ *
+ * @brief Placement of the LPs on nodes and threads
+ *
+ * By default, the LP ids are split in contiguous blocks, first among the nodes and then among the threads of each node.
+ * If a communication profile, as written by the log/comm_prof.c module, or a topology is configured, the LPs are
+ * instead placed by partitioning their communication graph: the LPs which exchange more messages end up on the same
+ * node and, within a node, on the same thread, while each node and thread gets roughly the same load. The load of an
+ * LP is the count of messages it receives in the profile, or a constant with a topology.
+ *
+ * Each graph is partitioned with a multilevel scheme: it is repeatedly coarsened by collapsing its heaviest edges, the
+ * coarsest graph is split by growing the parts breadth-first, then the split is projected back on the finer graphs and
+ * refined at each level by greedily moving the boundary vertices. The graph of all the LPs is partitioned among the
+ * nodes, then the subgraph of each node is partitioned among its threads. Every node computes the same placement,
+ * since this only depends on the configuration and on the profile.
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <lp/placement.h>
+
+#include <datatypes/array.h>
+#include <lib/topology/topology.h>
+#include <log/comm_prof.h>
+#include <log/log.h>
+#include <mm/mm.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// The count of vertices for each part below which a graph is not coarsened any further
+#define PLACEMENT_COARSEN_TO 16U
+/// The maximum load of a part, as a percentage of the average load
+#define PLACEMENT_IMBALANCE 103U
+/// The maximum count of refinement passes at each coarsening level
+#define PLACEMENT_REFINE_PASSES 8U
+/// The count of initial splits of the coarsest graph, from different starting vertices, the best of which is kept
+#define PLACEMENT_GROW_TRIALS 8U
+/// The weight given to a link of a topology, scaled by its probability for a TOPOLOGY_GRAPH
+#define PLACEMENT_TOPOLOGY_WEIGHT 100.0
+/// Marks a vertex not yet matched while coarsening a graph
+#define PLACEMENT_UNMATCHED UINT64_MAX
+
+/// An undirected graph in compressed sparse row format
+struct graph {
+	/// The count of vertices
+	lp_id_t n;
+	/// The offsets in @a adj and @a ew of the edges of each vertex, with an additional final one
+	uint64_t *xadj;
+	/// The endpoints of the edges
+	lp_id_t *adj;
+	/// The weights of the edges
+	uint64_t *ew;
+	/// The weights of the vertices
+	uint64_t *vw;
+};
+
+/// The location of each LP, NULL if the LPs are placed by blocks of contiguous ids
+struct lp_place *placement_lps;
+/// The ids of the LPs hosted on this node, grouped by thread and ascending within each thread
+lp_id_t *placement_order;
+/// The position in #placement_order of the first LP of each thread, with an additional final one
+lp_id_t *placement_thread_first;
+
+/**
+ * @brief Allocate the memory of a graph
+ * @param g the graph to allocate
+ * @param n the count of vertices
+ * @param m the count of edges, counting each undirected edge twice
+ */
+static void graph_alloc(struct graph *g, lp_id_t n, uint64_t m)
+{
+	g->n = n;
+	g->xadj = mm_alloc((n + 1) * sizeof(*g->xadj));
+	g->adj = mm_alloc(m * sizeof(*g->adj));
+	g->ew = mm_alloc(m * sizeof(*g->ew));
+	g->vw = mm_alloc(n * sizeof(*g->vw));
+}
+
+/**
+ * @brief Release the memory of a graph
+ * @param g the graph to release
+ */
+static void graph_fini(struct graph *g)
+{
+	mm_free(g->xadj);
+	mm_free(g->adj);
+	mm_free(g->ew);
+	mm_free(g->vw);
+}
+
+/**
+ * @brief Compute the total weight of the vertices of a graph
+ * @param g the graph
+ * @return the sum of the weights of the vertices of @p g
+ */
+static uint64_t graph_weight(const struct graph *g)
+{
+	uint64_t ret = 0;
+	for(lp_id_t v = 0; v < g->n; ++v)
+		ret += g->vw[v];
+	return ret;
+}
+
+/**
+ * @brief Build the graph of the communication between the LPs
+ * @param g the graph to build
+ * @param edges the directed and weighted communication edges, which are left in an unspecified order
+ * @param cnt the count of edges in @p edges
+ * @param rcv_load if set, the weight of each LP is increased by the weight of its incoming edges
+ */
+static void graph_build(struct graph *g, struct comm_edge *edges, uint64_t cnt, bool rcv_load)
+{
+	struct comm_edge *sym = mm_alloc(2 * cnt * sizeof(*sym));
+	uint64_t m = 0;
+	for(uint64_t i = 0; i < cnt; ++i) {
+		if(edges[i].from == edges[i].to)
+			continue;
+		sym[m++] = edges[i];
+		sym[m++] = (struct comm_edge){.from = edges[i].to, .to = edges[i].from, .cnt = edges[i].cnt};
+	}
+	m = comm_edges_compact(sym, m);
+
+	graph_alloc(g, global_config.lps, m);
+	memset(g->xadj, 0, (g->n + 1) * sizeof(*g->xadj));
+	for(uint64_t i = 0; i < m; ++i) {
+		++g->xadj[sym[i].from + 1];
+		g->adj[i] = sym[i].to;
+		g->ew[i] = sym[i].cnt;
+	}
+	for(lp_id_t v = 0; v < g->n; ++v) {
+		g->xadj[v + 1] += g->xadj[v];
+		g->vw[v] = 1;
+	}
+	mm_free(sym);
+
+	if(rcv_load)
+		for(uint64_t i = 0; i < cnt; ++i)
+			g->vw[edges[i].to] += edges[i].cnt;
+}
+
+/**
+ * @brief Coarsen a graph by collapsing the vertices joined by the heaviest edges
+ * @param g the graph to coarsen
+ * @param c the coarse graph to build
+ * @param cmap where to store the vertex of @p c which each vertex of @p g is collapsed into
+ * @param max_vw the maximum weight of a vertex of @p c
+ * @return true if the coarse graph has been built, false if it wouldn't be significantly smaller than @p g
+ */
+static bool graph_coarsen(const struct graph *g, struct graph *c, lp_id_t *cmap, uint64_t max_vw)
+{
+	for(lp_id_t v = 0; v < g->n; ++v)
+		cmap[v] = PLACEMENT_UNMATCHED;
+
+	// the members of each coarse vertex, the second one equal to the first one if the vertex wasn't matched
+	lp_id_t *members = mm_alloc(2 * g->n * sizeof(*members));
+	lp_id_t cn = 0;
+	for(lp_id_t v = 0; v < g->n; ++v) {
+		if(cmap[v] != PLACEMENT_UNMATCHED)
+			continue;
+
+		lp_id_t best = v;
+		uint64_t best_w = 0;
+		for(uint64_t e = g->xadj[v]; e < g->xadj[v + 1]; ++e) {
+			lp_id_t u = g->adj[e];
+			if(cmap[u] == PLACEMENT_UNMATCHED && g->ew[e] > best_w && g->vw[v] + g->vw[u] <= max_vw) {
+				best = u;
+				best_w = g->ew[e];
+			}
+		}
+		members[2 * cn] = v;
+		members[2 * cn + 1] = best;
+		cmap[v] = cmap[best] = cn++;
+	}
+
+	if(cn > g->n / 10 * 9) {
+		mm_free(members);
+		return false;
+	}
+
+	graph_alloc(c, cn, g->xadj[g->n]);
+	// the position in c->adj of the edge towards each coarse vertex, valid only if in the edges of the current vertex
+	lp_id_t *pos = mm_alloc(cn * sizeof(*pos));
+	for(lp_id_t i = 0; i < cn; ++i)
+		pos[i] = PLACEMENT_UNMATCHED;
+
+	uint64_t m = 0;
+	for(lp_id_t i = 0; i < cn; ++i) {
+		c->xadj[i] = m;
+		c->vw[i] = 0;
+		for(unsigned k = 0; k < 2; ++k) {
+			lp_id_t v = members[2 * i + k];
+			if(k && v == members[2 * i])
+				break;
+
+			c->vw[i] += g->vw[v];
+			for(uint64_t e = g->xadj[v]; e < g->xadj[v + 1]; ++e) {
+				lp_id_t u = cmap[g->adj[e]];
+				if(u == i)
+					continue;
+
+				if(pos[u] != PLACEMENT_UNMATCHED && pos[u] >= c->xadj[i]) {
+					c->ew[pos[u]] += g->ew[e];
+				} else {
+					pos[u] = m;
+					c->adj[m] = u;
+					c->ew[m++] = g->ew[e];
+				}
+			}
+		}
+	}
+	c->xadj[cn] = m;
+
+	mm_free(pos);
+	mm_free(members);
+	return true;
+}
+
+/**
+ * @brief Split a graph by growing the parts breadth-first, one after the other
+ * @param g the graph to split, with at least @p k vertices
+ * @param k the count of parts
+ * @param part where to store the part of each vertex
+ * @param start the vertex from which the first part grows
+ *
+ * Each part grows until its cumulative weight reaches its share of the total one. The next part starts from the
+ * vertices left in the frontier of the previous one, so that the parts stay contiguous.
+ */
+static void graph_grow(const struct graph *g, unsigned k, unsigned *part, lp_id_t start)
+{
+	uint64_t total = graph_weight(g);
+	lp_id_t *queue = mm_alloc(g->n * sizeof(*queue));
+	unsigned *queued = mm_alloc(g->n * sizeof(*queued));
+	for(lp_id_t v = 0; v < g->n; ++v)
+		part[v] = queued[v] = k;
+
+	lp_id_t left = g->n, scan = start, head = 0, tail = 0;
+	uint64_t done_w = 0;
+	for(unsigned p = 0; p < k; ++p) {
+		lp_id_t kept = 0;
+		for(lp_id_t i = head; i < tail; ++i) {
+			if(part[queue[i]] != k)
+				continue;
+			queued[queue[i]] = p;
+			queue[kept++] = queue[i];
+		}
+		head = 0;
+		tail = kept;
+
+		uint64_t limit = total / k * (p + 1) + total % k * (p + 1) / k;
+		lp_id_t cnt = 0;
+		// leave at least a vertex for each of the following parts
+		while(left > k - 1 - p && (p == k - 1 || !cnt || done_w < limit)) {
+			if(head == tail) {
+				while(part[scan] != k)
+					scan = scan + 1 < g->n ? scan + 1 : 0;
+				queued[scan] = p;
+				queue[tail++] = scan;
+			}
+
+			lp_id_t v = queue[head++];
+			part[v] = p;
+			done_w += g->vw[v];
+			--left;
+			++cnt;
+
+			for(uint64_t e = g->xadj[v]; e < g->xadj[v + 1]; ++e) {
+				lp_id_t u = g->adj[e];
+				if(part[u] == k && queued[u] != p) {
+					queued[u] = p;
+					queue[tail++] = u;
+				}
+			}
+		}
+	}
+
+	mm_free(queued);
+	mm_free(queue);
+}
+
+/**
+ * @brief Refine the split of a graph by greedily moving its boundary vertices
+ * @param g the split graph
+ * @param k the count of parts
+ * @param part the part of each vertex, updated in place
+ *
+ * A vertex moves to the adjacent part it is most connected to, if this cuts fewer edge weight and doesn't overload
+ * the destination part. Vertices also move at no cut gain to lighter parts, and at any cost out of overloaded parts.
+ * No part is ever left empty.
+ */
+static void graph_refine(const struct graph *g, unsigned k, unsigned *part)
+{
+	uint64_t *pw = mm_alloc(k * sizeof(*pw));
+	lp_id_t *pcnt = mm_alloc(k * sizeof(*pcnt));
+	uint64_t *conn = mm_alloc(k * sizeof(*conn));
+	unsigned *touched = mm_alloc(k * sizeof(*touched));
+	memset(pw, 0, k * sizeof(*pw));
+	memset(pcnt, 0, k * sizeof(*pcnt));
+	memset(conn, 0, k * sizeof(*conn));
+
+	uint64_t max_vw = 0;
+	for(lp_id_t v = 0; v < g->n; ++v) {
+		pw[part[v]] += g->vw[v];
+		++pcnt[part[v]];
+		max_vw = max(max_vw, g->vw[v]);
+	}
+	uint64_t total = graph_weight(g);
+	uint64_t max_w = max(total / k * PLACEMENT_IMBALANCE / 100, total / k + max_vw);
+
+	for(unsigned pass = 0; pass < PLACEMENT_REFINE_PASSES; ++pass) {
+		lp_id_t moved = 0;
+		for(lp_id_t v = 0; v < g->n; ++v) {
+			unsigned a = part[v], t = 0;
+			for(uint64_t e = g->xadj[v]; e < g->xadj[v + 1]; ++e) {
+				unsigned b = part[g->adj[e]];
+				if(!conn[b])
+					touched[t++] = b;
+				conn[b] += g->ew[e];
+			}
+
+			unsigned best = a;
+			int64_t best_gain = INT64_MIN;
+			for(unsigned i = 0; i < t && pcnt[a] > 1; ++i) {
+				unsigned b = touched[i];
+				if(b == a || pw[b] + g->vw[v] > max_w)
+					continue;
+
+				int64_t gain = (int64_t)conn[b] - (int64_t)conn[a];
+				bool worth = gain > 0 || pw[a] > max_w || (gain == 0 && pw[b] + g->vw[v] < pw[a]);
+				if(worth && gain > best_gain) {
+					best = b;
+					best_gain = gain;
+				}
+			}
+
+			for(unsigned i = 0; i < t; ++i)
+				conn[touched[i]] = 0;
+
+			if(best == a)
+				continue;
+
+			pw[a] -= g->vw[v];
+			pw[best] += g->vw[v];
+			--pcnt[a];
+			++pcnt[best];
+			part[v] = best;
+			++moved;
+		}
+
+		if(!moved)
+			break;
+	}
+
+	mm_free(touched);
+	mm_free(conn);
+	mm_free(pcnt);
+	mm_free(pw);
+}
+
+/**
+ * @brief Compute the weight of the edges across parts
+ * @param g the split graph
+ * @param part the part of each vertex
+ * @return the weight of the edges of @p g whose endpoints lie in different parts, counted twice
+ */
+static uint64_t graph_cut(const struct graph *g, const unsigned *part)
+{
+	uint64_t ret = 0;
+	for(lp_id_t v = 0; v < g->n; ++v)
+		for(uint64_t e = g->xadj[v]; e < g->xadj[v + 1]; ++e)
+			ret += part[v] != part[g->adj[e]] ? g->ew[e] : 0;
+	return ret;
+}
+
+/**
+ * @brief Split the coarsest graph, keeping the best of several refined splits grown from different vertices
+ * @param g the graph to split, with at least @p k vertices
+ * @param k the count of parts
+ * @param part where to store the part of each vertex
+ */
+static void graph_split(const struct graph *g, unsigned k, unsigned *part)
+{
+	unsigned *trial = mm_alloc(g->n * sizeof(*trial));
+	uint64_t best_cut = UINT64_MAX;
+	for(unsigned t = 0; t < PLACEMENT_GROW_TRIALS; ++t) {
+		graph_grow(g, k, trial, g->n / PLACEMENT_GROW_TRIALS * t);
+		graph_refine(g, k, trial);
+		uint64_t cut = graph_cut(g, trial);
+		if(cut < best_cut) {
+			best_cut = cut;
+			memcpy(part, trial, g->n * sizeof(*part));
+		}
+	}
+	mm_free(trial);
+}
+
+/**
+ * @brief Partition a graph in parts of balanced weight, minimizing the weight of the edges across parts
+ * @param g the graph to partition, with at least @p k vertices
+ * @param k the count of parts
+ * @param part where to store the part of each vertex
+ */
+static void graph_partition(const struct graph *g, unsigned k, unsigned *part)
+{
+	if(k == 1) {
+		memset(part, 0, g->n * sizeof(*part));
+		return;
+	}
+
+	if(g->n > (lp_id_t)PLACEMENT_COARSEN_TO * k) {
+		struct graph c;
+		lp_id_t *cmap = mm_alloc(g->n * sizeof(*cmap));
+		uint64_t max_vw = graph_weight(g) * 3 / (2 * PLACEMENT_COARSEN_TO * k) + 1;
+		if(graph_coarsen(g, &c, cmap, max_vw)) {
+			unsigned *cpart = mm_alloc(c.n * sizeof(*cpart));
+			graph_partition(&c, k, cpart);
+			for(lp_id_t v = 0; v < g->n; ++v)
+				part[v] = cpart[cmap[v]];
+
+			mm_free(cpart);
+			graph_fini(&c);
+			mm_free(cmap);
+			graph_refine(g, k, part);
+			return;
+		}
+		mm_free(cmap);
+	}
+
+	graph_split(g, k, part);
+}
+
+/**
+ * @brief Extract the subgraph induced by the vertices of a part
+ * @param g the partitioned graph
+ * @param part the part of each vertex of @p g
+ * @param p the part whose vertices are extracted
+ * @param s the subgraph to build
+ * @param map where to store the vertex of @p g corresponding to each vertex of @p s
+ * @param loc a scratch buffer with room for a vertex id for each vertex of @p g
+ */
+static void graph_subgraph(const struct graph *g, const unsigned *part, unsigned p, struct graph *s, lp_id_t *map,
+    lp_id_t *loc)
+{
+	lp_id_t n = 0;
+	uint64_t m = 0;
+	for(lp_id_t v = 0; v < g->n; ++v) {
+		if(part[v] != p)
+			continue;
+		loc[v] = n;
+		map[n++] = v;
+		for(uint64_t e = g->xadj[v]; e < g->xadj[v + 1]; ++e)
+			m += part[g->adj[e]] == p;
+	}
+
+	graph_alloc(s, n, m);
+	m = 0;
+	for(lp_id_t i = 0; i < n; ++i) {
+		lp_id_t v = map[i];
+		s->xadj[i] = m;
+		s->vw[i] = g->vw[v];
+		for(uint64_t e = g->xadj[v]; e < g->xadj[v + 1]; ++e) {
+			if(part[g->adj[e]] != p)
+				continue;
+			s->adj[m] = loc[g->adj[e]];
+			s->ew[m++] = g->ew[e];
+		}
+	}
+	s->xadj[n] = m;
+}
+
+/**
+ * @brief Build the communication graph of the LPs from the configured profile
+ * @param g the graph to build
+ *
+ * The profile has the format written by the log/comm_prof.c module.
+ */
+static void placement_graph_profile(struct graph *g)
+{
+	FILE *f = fopen(global_config.placement_profile, "r");
+	if(unlikely(f == NULL)) {
+		logger(LOG_FATAL, "Unable to open the LP communication profile %s", global_config.placement_profile);
+		abort();
+	}
+
+	dyn_array(struct comm_edge) edges;
+	array_init(edges);
+	char line[256];
+	uint64_t l = 0;
+	while(fgets(line, sizeof(line), f) != NULL) {
+		++l;
+		if(line[0] == '#' || line[0] == '\n')
+			continue;
+
+		struct comm_edge e;
+		if(unlikely(sscanf(line, "%" SCNu64 " %" SCNu64 " %" SCNu64, &e.from, &e.to, &e.cnt) != 3 ||
+			    e.from >= global_config.lps || e.to >= global_config.lps)) {
+			logger(LOG_FATAL, "Malformed LP communication profile %s at line %" PRIu64,
+			    global_config.placement_profile, l);
+			abort();
+		}
+		if(e.cnt)
+			array_push(edges, e);
+	}
+	fclose(f);
+
+	graph_build(g, array_items(edges), array_count(edges), true);
+	array_fini(edges);
+}
+
+/**
+ * @brief Build the communication graph of the LPs from the configured topology
+ * @param g the graph to build
+ *
+ * Each LP is linked to its neighbors in the topology, the regions outside the LP id space are ignored.
+ */
+static void placement_graph_topology(struct graph *g)
+{
+	struct topology *topology = global_config.placement_topology;
+	lp_id_t regions = min(CountRegions(topology), global_config.lps);
+
+	dyn_array(struct comm_edge) edges;
+	array_init(edges);
+	lp_id_t links_cap = 0;
+	lp_id_t *links = NULL;
+	double *weights = NULL;
+	for(lp_id_t from = 0; from < regions; ++from) {
+		lp_id_t cnt = max(CountDirections(from, topology), (lp_id_t)DIRECTION_RANDOM);
+		if(cnt > links_cap) {
+			links_cap = cnt;
+			links = mm_realloc(links, links_cap * sizeof(*links));
+			weights = mm_realloc(weights, links_cap * sizeof(*weights));
+		}
+
+		cnt = topology_links_get(topology, from, links, weights);
+		for(lp_id_t i = 0; i < cnt; ++i) {
+			if(links[i] >= global_config.lps)
+				continue;
+			uint64_t w = max((uint64_t)(weights[i] * PLACEMENT_TOPOLOGY_WEIGHT), (uint64_t)1);
+			struct comm_edge e = {.from = from, .to = links[i], .cnt = w};
+			array_push(edges, e);
+		}
+	}
+	mm_free(weights);
+	mm_free(links);
+
+	graph_build(g, array_items(edges), array_count(edges), false);
+	array_fini(edges);
+}
+
+/**
+ * @brief Log how much of the communication the placement keeps within nodes and threads
+ * @param g the communication graph of the LPs
+ */
+static void placement_report(const struct graph *g)
+{
+	uint64_t total = 0, remote = 0, local = 0;
+	for(lp_id_t v = 0; v < g->n; ++v) {
+		for(uint64_t e = g->xadj[v]; e < g->xadj[v + 1]; ++e) {
+			struct lp_place a = placement_lps[v], b = placement_lps[g->adj[e]];
+			total += g->ew[e];
+			remote += a.nid != b.nid ? g->ew[e] : 0;
+			local += a.nid == b.nid && a.rid == b.rid ? g->ew[e] : 0;
+		}
+	}
+
+	if(nid || !total)
+		return;
+
+	logger(LOG_INFO, "LP placement: %.1lf%% of the communication within threads, %.1lf%% across nodes",
+	    100.0 * (double)local / (double)total, 100.0 * (double)remote / (double)total);
+}
+
+/**
+ * @brief Compute the placement of the LPs, if requested in the configuration
+ *
+ * If neither a communication profile nor a topology has been configured, the LPs are placed by blocks of contiguous
+ * ids and the placement tables are left NULL.
+ */
+void placement_global_init(void)
+{
+	if(likely(global_config.placement_profile == NULL && global_config.placement_topology == NULL))
+		return;
+
+	rid_t n_threads = global_config.n_threads;
+	if(unlikely(global_config.lps < (lp_id_t)n_nodes * n_threads)) {
+		logger(LOG_WARN, "Too few LPs to compute a placement, they will be placed by blocks of ids");
+		return;
+	}
+
+	struct graph g;
+	if(global_config.placement_profile != NULL)
+		placement_graph_profile(&g);
+	else
+		placement_graph_topology(&g);
+
+	unsigned *node_part = mm_alloc(g.n * sizeof(*node_part));
+	unsigned *thread_part = mm_alloc(g.n * sizeof(*thread_part));
+	lp_id_t *map = mm_alloc(g.n * sizeof(*map));
+	lp_id_t *loc = mm_alloc(g.n * sizeof(*loc));
+	placement_lps = mm_alloc(g.n * sizeof(*placement_lps));
+
+	graph_partition(&g, n_nodes, node_part);
+	bool fits = true;
+	for(nid_t j = 0; j < n_nodes && fits; ++j) {
+		struct graph s;
+		graph_subgraph(&g, node_part, j, &s, map, loc);
+		fits = s.n >= n_threads;
+		if(fits) {
+			graph_partition(&s, n_threads, thread_part);
+			for(lp_id_t i = 0; i < s.n; ++i)
+				placement_lps[map[i]] = (struct lp_place){.nid = j, .rid = thread_part[i]};
+		}
+		graph_fini(&s);
+	}
+
+	mm_free(loc);
+	mm_free(map);
+	mm_free(thread_part);
+	mm_free(node_part);
+
+	if(unlikely(!fits)) {
+		logger(LOG_WARN, "Unable to give some LPs to each thread, they will be placed by blocks of ids");
+		mm_free(placement_lps);
+		placement_lps = NULL;
+		graph_fini(&g);
+		return;
+	}
+
+	placement_report(&g);
+	graph_fini(&g);
+
+	placement_thread_first = mm_alloc((n_threads + 1) * sizeof(*placement_thread_first));
+	memset(placement_thread_first, 0, (n_threads + 1) * sizeof(*placement_thread_first));
+	for(lp_id_t i = 0; i < global_config.lps; ++i)
+		if(placement_lps[i].nid == nid)
+			++placement_thread_first[placement_lps[i].rid + 1];
+	for(rid_t i = 0; i < n_threads; ++i)
+		placement_thread_first[i + 1] += placement_thread_first[i];
+
+	lp_id_t *fill = mm_alloc(n_threads * sizeof(*fill));
+	memcpy(fill, placement_thread_first, n_threads * sizeof(*fill));
+	placement_order = mm_alloc(placement_thread_first[n_threads] * sizeof(*placement_order));
+	for(lp_id_t i = 0; i < global_config.lps; ++i) {
+		if(placement_lps[i].nid == nid) {
+			placement_lps[i].idx = fill[placement_lps[i].rid]++;
+			placement_order[placement_lps[i].idx] = i;
+		}
+	}
+	mm_free(fill);
+}
+
+/**
+ * @brief Release the placement tables of the LPs
+ */
+void placement_global_fini(void)
+{
+	if(placement_lps == NULL)
+		return;
+
+	mm_free(placement_order);
+	mm_free(placement_thread_first);
+	mm_free(placement_lps);
+	placement_order = NULL;
+	placement_thread_first = NULL;
+	placement_lps = NULL;
+}
@@ -0,0 +1,28 @@
+/**
+ * @file lp/placement.h
+ *
+ * @brief Placement of the LPs on nodes and threads
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#pragma once
+
+#include <core/core.h>
+
+/// The location of an LP
+struct lp_place {
+	/// The id of the node hosting the LP
+	nid_t nid;
+	/// The id of the thread hosting the LP
+	rid_t rid;
+	/// The position of the LP in #placement_order, meaningful only for the LPs hosted on this node
+	lp_id_t idx;
+};
+
+extern struct lp_place *placement_lps;
+extern lp_id_t *placement_order;
+extern lp_id_t *placement_thread_first;
+
+extern void placement_global_init(void);
+extern void placement_global_fini(void);
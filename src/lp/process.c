@@ -15,11 +15,13 @@
 #include <distributed/mpi.h>
 #include <gvt/fossil.h>
 #include <gvt/gvt.h>
+#include <log/comm_prof.h>
 #include <log/stats.h>
 #include <lp/common.h>
 #include <lp/lp.h>
 #include <mm/auto_ckpt.h>
 #include <mm/msg_allocator.h>
+#include <mm/paging.h>
 #include <serial/serial.h>
 
 /// The flag used in ScheduleNewEvent() to keep track of silent execution
@@ -46,6 +48,8 @@ void ScheduleNewEvent(lp_id_t receiver, simtime_t timestamp, unsigned event_type
 	if(unlikely(silent_processing))
 		return;
 
+	comm_prof_sample(lp_id_get(current_lp), receiver);
+
 	struct lp_msg *msg = msg_allocator_pack(receiver, timestamp, event_type, payload, payload_size);
 
 #ifndef NDEBUG
@@ -54,7 +58,7 @@ void ScheduleNewEvent(lp_id_t receiver, simtime_t timestamp, unsigned event_type
 		logger(LOG_FATAL, "Scheduling a message in the past!");
 		abort();
 	}
-	msg->send = current_lp - lps;
+	msg->send = lp_id_get(current_lp);
 	msg->send_t = current_msg->dest_t;
 #endif
 
@@ -77,11 +81,14 @@ void ScheduleNewEvent(lp_id_t receiver, simtime_t timestamp, unsigned event_type
  */
 static inline void checkpoint_take(struct lp_ctx *lp)
 {
+	struct lp_cold_ctx *lp_c = lp_cold(lp);
 	timer_uint t = timer_hr_new();
-	model_allocator_checkpoint_take(&lp->mm_state, array_count(lp->p.p_msgs));
-	stats_take(STATS_CKPT_SIZE, lp->mm_state.full_ckpt_size);
+	model_allocator_checkpoint_take(&lp_c->mm_state, array_count(lp->p.p_msgs));
+	t = timer_hr_value(t);
+	auto_ckpt_register_ckpt(&lp_c->auto_ckpt_prof, t, lp_c->mm_state.full_ckpt_size);
+	stats_take(STATS_CKPT_SIZE, lp_c->mm_state.full_ckpt_size);
 	stats_take(STATS_CKPT, 1);
-	stats_take(STATS_CKPT_TIME, timer_hr_value(t));
+	stats_take(STATS_CKPT_TIME, t);
 }
 
 /**
@@ -90,9 +97,9 @@ static inline void checkpoint_take(struct lp_ctx *lp)
 void process_lp_init(struct lp_ctx *lp)
 {
 	array_init(lp->p.p_msgs);
-	lp->p.early_antis = NULL;
+	lp_cold(lp)->early_antis = NULL;
 
-	struct lp_msg *msg = msg_allocator_pack(lp - lps, 0, LP_INIT, NULL, 0U);
+	struct lp_msg *msg = msg_allocator_pack(lp_id_get(lp), 0, LP_INIT, NULL, 0U);
 	msg->raw_flags = MSG_FLAG_PROCESSED;
 #ifndef NDEBUG
 	current_msg = msg;
@@ -101,7 +108,7 @@ void process_lp_init(struct lp_ctx *lp)
 	common_msg_process(lp, msg);
 	lp->p.bound = 0.0;
 	array_push(lp->p.p_msgs, msg);
-	model_allocator_checkpoint_next_force_full(&lp->mm_state);
+	model_allocator_checkpoint_next_force_full(&lp_cold(lp)->mm_state);
 	checkpoint_take(lp);
 }
 
@@ -111,7 +118,10 @@ void process_lp_init(struct lp_ctx *lp)
 void process_lp_fini(struct lp_ctx *lp)
 {
 	current_lp = lp;
-	global_config.dispatcher(lp - lps, 0, LP_FINI, NULL, 0, lp->state_pointer);
+	global_config.dispatcher(lp_id_get(lp), 0, LP_FINI, NULL, 0, lp->state_pointer);
+
+	if(global_config.fast_teardown)
+		return;
 
 	for(array_count_t i = 0; i < array_count(lp->p.p_msgs); ++i) {
 		struct lp_msg *msg = array_get_at(lp->p.p_msgs, i);
@@ -135,7 +145,7 @@ void process_lp_fini(struct lp_ctx *lp)
  *
  * This function implements the coasting forward operation done after a checkpoint has been restored.
  */
-static inline void silent_execution(const struct lp_ctx *lp, array_count_t last_i, array_count_t past_i)
+static inline void silent_execution(struct lp_ctx *lp, array_count_t last_i, array_count_t past_i)
 {
 	if(unlikely(last_i >= past_i))
 		return;
@@ -144,6 +154,7 @@ static inline void silent_execution(const struct lp_ctx *lp, array_count_t last_
 	silent_processing = true;
 
 	void *state_p = lp->state_pointer;
+	uint_fast64_t cnt = 0;
 	do {
 		const struct lp_msg *msg = array_get_at(lp->p.p_msgs, last_i);
 		while(is_msg_sent(msg))
@@ -151,10 +162,13 @@ static inline void silent_execution(const struct lp_ctx *lp, array_count_t last_
 
 		global_config.dispatcher(msg->dest, msg->dest_t, msg->m_type, msg->pl, msg->pl_size, state_p);
 		stats_take(STATS_MSG_SILENT, 1);
+		++cnt;
 	} while(++last_i < past_i);
 
 	silent_processing = false;
-	stats_take(STATS_MSG_SILENT_TIME, timer_hr_value(t));
+	t = timer_hr_value(t);
+	auto_ckpt_register_silent(&lp_cold(lp)->auto_ckpt_prof, t, cnt);
+	stats_take(STATS_MSG_SILENT_TIME, t);
 }
 
 /**
@@ -203,7 +217,7 @@ static void do_rollback(struct lp_ctx *lp, array_count_t past_i)
 {
 	timer_uint t = timer_hr_new();
 	send_anti_messages(&lp->p, past_i);
-	array_count_t last_i = model_allocator_checkpoint_restore(&lp->mm_state, past_i);
+	array_count_t last_i = model_allocator_checkpoint_restore(&lp_cold(lp)->mm_state, past_i);
 	stats_take(STATS_RECOVERY_TIME, timer_hr_value(t));
 	stats_take(STATS_ROLLBACK, 1);
 	silent_execution(lp, last_i, past_i);
@@ -264,8 +278,8 @@ static inline void handle_remote_anti_msg(struct lp_ctx *lp, struct lp_msg *a_ms
 	do {
 		if(unlikely(!i)) {
 			// Sadly this is an early remote anti-message
-			a_msg->next = lp->p.early_antis;
-			lp->p.early_antis = a_msg;
+			a_msg->next = lp_cold(lp)->early_antis;
+			lp_cold(lp)->early_antis = a_msg;
 			return;
 		}
 		msg = array_get_at(lp->p.p_msgs, --i);
@@ -288,14 +302,14 @@ static inline void handle_remote_anti_msg(struct lp_ctx *lp, struct lp_msg *a_ms
 
 /**
  * @brief Check if a remote message has already been invalidated by an early remote anti-message
- * @param proc_p the message processing data of the current LP
+ * @param lp_c the cold context of the current LP
  * @param a_msg the remote message to check
  * @return true if the message has been matched with an early remote anti-message, false otherwise
  */
-static inline bool check_early_anti_messages(struct process_ctx *proc_p, struct lp_msg *msg)
+static inline bool check_early_anti_messages(struct lp_cold_ctx *lp_c, struct lp_msg *msg)
 {
 	uint32_t m_id = msg->raw_flags, m_seq = msg->m_seq;
-	struct lp_msg **prev_p = &proc_p->early_antis;
+	struct lp_msg **prev_p = &lp_c->early_antis;
 	struct lp_msg *a_msg = *prev_p;
 	do {
 		if(a_msg->raw_flags == m_id && a_msg->m_seq == m_seq) {
@@ -320,13 +334,13 @@ static void handle_anti_msg(struct lp_ctx *lp, struct lp_msg *msg, uint32_t last
 {
 	if(last_flags > (MSG_FLAG_ANTI | MSG_FLAG_PROCESSED)) {
 		handle_remote_anti_msg(lp, msg);
-		auto_ckpt_register_bad(&lp->auto_ckpt);
+		auto_ckpt_register_bad(&lp_cold(lp)->auto_ckpt_prof);
 		return;
 	} else if(last_flags == (MSG_FLAG_ANTI | MSG_FLAG_PROCESSED)) {
 		array_count_t past_i = match_anti_msg(&lp->p, msg);
 		do_rollback(lp, past_i);
 		termination_on_lp_rollback(lp, msg->dest_t);
-		auto_ckpt_register_bad(&lp->auto_ckpt);
+		auto_ckpt_register_bad(&lp_cold(lp)->auto_ckpt_prof);
 	}
 	msg_allocator_free(msg);
 }
@@ -341,7 +355,7 @@ static void handle_straggler_msg(struct lp_ctx *lp, struct lp_msg *msg)
 	array_count_t past_i = match_straggler_msg(&lp->p, msg);
 	do_rollback(lp, past_i);
 	termination_on_lp_rollback(lp, msg->dest_t);
-	auto_ckpt_register_bad(&lp->auto_ckpt);
+	auto_ckpt_register_bad(&lp_cold(lp)->auto_ckpt_prof);
 }
 
 /**
@@ -359,12 +373,16 @@ void process_msg(void)
 
 	gvt_on_msg_extraction(msg->dest_t);
 
-	struct lp_ctx *lp = &lps[msg->dest];
+	struct lp_ctx *lp = lid_to_lp(msg->dest);
 	current_lp = lp;
 
+	// a paged out LP has been idle since the last GVT at least, so its fossil epoch is outdated
 	if(unlikely(fossil_is_needed(lp))) {
-		auto_ckpt_recompute(&lp->auto_ckpt, lp->mm_state.full_ckpt_size);
+		struct lp_cold_ctx *lp_c = lp_cold(lp);
+		paging_lp_ensure(lp);
+		auto_ckpt_recompute(&lp->auto_ckpt, &lp_c->auto_ckpt_prof, lp_c->mm_state.full_ckpt_size);
 		fossil_lp_collect(lp);
+		lp->fossil_epoch = fossil_epoch_current;
 		lp->p.bound = unlikely(array_is_empty(lp->p.p_msgs)) ? -1.0 : lp->p.bound;
 	}
 
@@ -375,7 +393,7 @@ void process_msg(void)
 		return;
 	}
 
-	if(unlikely(flags && lp->p.early_antis && check_early_anti_messages(&lp->p, msg)))
+	if(unlikely(flags && lp_cold(lp)->early_antis && check_early_anti_messages(lp_cold(lp), msg)))
 		return;
 
 	if(unlikely(lp->p.bound >= msg->dest_t && msg_is_before(msg, array_peek(lp->p.p_msgs))))
@@ -10,7 +10,9 @@
  */
 #include <mm/auto_ckpt.h>
 
+#include <arch/mem.h>
 #include <log/stats.h>
+#include <lp/lp.h>
 #include <lp/process.h>
 
 #include <math.h>
@@ -29,11 +31,117 @@
 		o *(((f)-1.0) / (f)) + s *(1.0 / (f));                                                                 \
 	})
 
+/// The costs estimated by a checkpointing interval selection policy for a LP
+struct ckpt_costs {
+	/// The checkpointing time per byte of state
+	double ckpt;
+	/// The silent execution time per event
+	double sil;
+	/// The factor applied to the interval which minimizes the estimated costs
+	double stretch;
+};
+
+/// A checkpointing interval selection policy
+struct ckpt_policy_ops {
+	/// Update the thread-wide data of the policy, called at the end of GVT reductions
+	void (*on_gvt)(void);
+	/// Estimate the costs for a LP
+	struct ckpt_costs (*costs)(const struct auto_ckpt_prof *prof);
+};
+
 static __thread struct {
 	double ckpt_avg_cost;
 	double inv_sil_avg_cost;
+	/// The interval stretch factor computed by the memory policy
+	double mem_stretch;
+	/// The memory budget of the memory policy
+	size_t mem_budget;
+	/// The policy in use in this thread
+	const struct ckpt_policy_ops *policy;
 } ackpt;
 
+/**
+ * @brief Update the thread-wide cost averages
+ */
+static void thread_policy_on_gvt(void)
+{
+	uint64_t ckpt_cost = stats_retrieve(STATS_CKPT_TIME);
+	uint64_t ckpt_size = stats_retrieve(STATS_CKPT_SIZE);
+	uint64_t sil_count = stats_retrieve(STATS_MSG_SILENT);
+	uint64_t sil_cost = stats_retrieve(STATS_MSG_SILENT_TIME);
+
+	if(likely(sil_count && sil_cost))
+		ackpt.inv_sil_avg_cost = EXP_AVG(16.0, ackpt.inv_sil_avg_cost, (double)sil_count / (double)sil_cost);
+
+	if(likely(ckpt_size))
+		ackpt.ckpt_avg_cost = EXP_AVG(16.0, ackpt.ckpt_avg_cost, (double)ckpt_cost / (double)ckpt_size);
+}
+
+/**
+ * @brief Estimate the costs for a LP using the thread-wide averages
+ * @param prof a pointer to the auto checkpoint profiling data of the LP
+ * @return the estimated costs
+ */
+static struct ckpt_costs thread_policy_costs(const struct auto_ckpt_prof *prof)
+{
+	(void)prof;
+	return (struct ckpt_costs){.ckpt = ackpt.ckpt_avg_cost, .sil = 1.0 / ackpt.inv_sil_avg_cost, .stretch = 1.0};
+}
+
+/**
+ * @brief Estimate the costs for a LP using its own profile, if available
+ * @param prof a pointer to the auto checkpoint profiling data of the LP
+ * @return the estimated costs
+ *
+ * The thread-wide averages are used until the LP has taken a checkpoint or carried out a silent execution.
+ */
+static struct ckpt_costs lp_policy_costs(const struct auto_ckpt_prof *prof)
+{
+	struct ckpt_costs ret = thread_policy_costs(prof);
+	if(prof->ckpt_cost > 0.0)
+		ret.ckpt = prof->ckpt_cost;
+	if(prof->sil_cost > 0.0)
+		ret.sil = prof->sil_cost;
+	return ret;
+}
+
+/**
+ * @brief Update the thread-wide cost averages and the memory pressure
+ *
+ * Up to half of the memory budget the intervals are not affected. Above that, they are stretched so that the
+ * checkpoints, and therefore the memory retained by them, become progressively rarer.
+ */
+static void memory_policy_on_gvt(void)
+{
+	thread_policy_on_gvt();
+
+	if(unlikely(!ackpt.mem_budget))
+		return;
+
+	double p = (double)mem_stat_rss_current_get() / (double)ackpt.mem_budget;
+	double q = min(max(2.0 * p - 1.0, 0.0), 0.9);
+	ackpt.mem_stretch = 1.0 / (1.0 - q);
+}
+
+/**
+ * @brief Estimate the costs for a LP using the thread-wide averages, accounting for memory pressure
+ * @param prof a pointer to the auto checkpoint profiling data of the LP
+ * @return the estimated costs
+ */
+static struct ckpt_costs memory_policy_costs(const struct auto_ckpt_prof *prof)
+{
+	struct ckpt_costs ret = thread_policy_costs(prof);
+	ret.stretch = ackpt.mem_stretch;
+	return ret;
+}
+
+/// The available checkpointing interval selection policies
+static const struct ckpt_policy_ops ckpt_policies[] = {
+    [CKPT_POLICY_THREAD] = {.on_gvt = thread_policy_on_gvt, .costs = thread_policy_costs},
+    [CKPT_POLICY_LP] = {.on_gvt = thread_policy_on_gvt, .costs = lp_policy_costs},
+    [CKPT_POLICY_MEMORY] = {.on_gvt = memory_policy_on_gvt, .costs = memory_policy_costs}
+};
+
 /**
  * @brief Initialize the thread-local context for the auto checkpoint module
  */
@@ -41,6 +149,9 @@ void auto_ckpt_init(void)
 {
 	ackpt.ckpt_avg_cost = 1.0;
 	ackpt.inv_sil_avg_cost = 1.0 / 4096.0;
+	ackpt.mem_stretch = 1.0;
+	ackpt.mem_budget = global_config.ckpt_mem_budget ? global_config.ckpt_mem_budget : mem_stat_phys_get();
+	ackpt.policy = &ckpt_policies[global_config.ckpt_policy];
 }
 
 /**
@@ -51,45 +162,70 @@ void auto_ckpt_init(void)
  */
 void auto_ckpt_on_gvt(void)
 {
+	if(likely(lid_thread_end > lid_thread_first)) {
+		uint64_t sum = 0;
+		for(uint64_t i = lid_thread_first; i < lid_thread_end; ++i)
+			sum += lps[i].auto_ckpt.ckpt_interval;
+		stats_take(STATS_CKPT_INTERVAL, sum / (lid_thread_end - lid_thread_first));
+	}
+
 	if(unlikely(global_config.ckpt_interval))
 		return;
 
-	uint64_t ckpt_cost = stats_retrieve(STATS_CKPT_TIME);
-	uint64_t ckpt_size = stats_retrieve(STATS_CKPT_SIZE);
-	uint64_t sil_count = stats_retrieve(STATS_MSG_SILENT);
-	uint64_t sil_cost = stats_retrieve(STATS_MSG_SILENT_TIME);
-
-	if(likely(sil_count))
-		ackpt.inv_sil_avg_cost = EXP_AVG(16.0, ackpt.inv_sil_avg_cost, (double)sil_count / (double)sil_cost);
-
-	if(likely(ckpt_size))
-		ackpt.ckpt_avg_cost = EXP_AVG(16.0, ackpt.ckpt_avg_cost, (double)ckpt_cost / (double)ckpt_size);
+	ackpt.policy->on_gvt();
 }
 
 /**
  * @brief Initialize the per-LP context for the auto checkpoint module
- * @param auto_ckpt a pointer to the LP auto checkpoint context to initialize
+ * @param auto_ckpt a pointer to the LP auto checkpoint counters to initialize
+ * @param prof a pointer to the LP auto checkpoint profiling data to initialize
  */
-void auto_ckpt_lp_init(struct auto_ckpt *auto_ckpt)
+void auto_ckpt_lp_init(struct auto_ckpt *auto_ckpt, struct auto_ckpt_prof *prof)
 {
 	memset(auto_ckpt, 0, sizeof(*auto_ckpt));
+	memset(prof, 0, sizeof(*prof));
 	auto_ckpt->ckpt_interval = global_config.ckpt_interval ? global_config.ckpt_interval : 256;
-	auto_ckpt->inv_bad_p = 64.0;
+	prof->inv_bad_p = 64.0;
 }
 
 /**
  * @brief Compute the optimal checkpoint interval of the current LP and set it
- * @param auto_ckpt a pointer to the auto checkpoint context of the current LP
+ * @param auto_ckpt a pointer to the auto checkpoint counters of the current LP
+ * @param prof a pointer to the auto checkpoint profiling data of the current LP
  * @param state_size the size in bytes of the checkpoint-able state of the current LP
+ *
+ * Before selecting the new interval, the cost predicted for the events processed with the previous one is
+ * reported along with the observed one.
  */
-void auto_ckpt_recompute(struct auto_ckpt *auto_ckpt, uint_fast32_t state_size)
+void auto_ckpt_recompute(struct auto_ckpt *auto_ckpt, struct auto_ckpt_prof *prof, uint_fast32_t state_size)
 {
-	if(unlikely(!auto_ckpt->m_bad || global_config.ckpt_interval))
+	if(unlikely(!prof->m_bad || global_config.ckpt_interval))
 		return;
 
-	auto_ckpt->inv_bad_p = EXP_AVG(8.0, auto_ckpt->inv_bad_p, 2.0 * auto_ckpt->m_good / auto_ckpt->m_bad);
-	auto_ckpt->m_bad = 0;
+	struct ckpt_costs c = ackpt.policy->costs(prof);
+	double ckpt_cost = c.ckpt * (double)state_size;
+	double predicted = auto_ckpt->m_good * ckpt_cost / auto_ckpt->ckpt_interval +
+			   prof->m_bad * c.sil * (auto_ckpt->ckpt_interval - 1) / 2.0;
+	stats_take(STATS_CKPT_COST_PREDICTED, (uint_fast64_t)predicted);
+	stats_take(STATS_CKPT_COST_OBSERVED, prof->ckpt_time + prof->sil_time);
+
+	if(prof->ckpt_size) {
+		double s = (double)prof->ckpt_time / (double)prof->ckpt_size;
+		prof->ckpt_cost = prof->ckpt_cost > 0.0 ? EXP_AVG(8.0, prof->ckpt_cost, s) : s;
+	}
+
+	if(prof->sil_count) {
+		double s = (double)prof->sil_time / (double)prof->sil_count;
+		prof->sil_cost = prof->sil_cost > 0.0 ? EXP_AVG(8.0, prof->sil_cost, s) : s;
+	}
+
+	prof->ckpt_time = 0;
+	prof->ckpt_size = 0;
+	prof->sil_time = 0;
+	prof->sil_count = 0;
+
+	prof->inv_bad_p = EXP_AVG(8.0, prof->inv_bad_p, 2.0 * auto_ckpt->m_good / prof->m_bad);
+	prof->m_bad = 0;
 	auto_ckpt->m_good = 0;
-	auto_ckpt->ckpt_interval =
-	    ceil(sqrt(auto_ckpt->inv_bad_p * ackpt.ckpt_avg_cost * ackpt.inv_sil_avg_cost * (double)state_size));
+	auto_ckpt->ckpt_interval = ceil(c.stretch * sqrt(prof->inv_bad_p * ckpt_cost / c.sil));
 }
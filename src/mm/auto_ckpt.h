@@ -12,25 +12,41 @@
 
 #include <inttypes.h>
 
-/// Structure to keep data used for autonomic checkpointing selection
+/// The per-event counters of the autonomic checkpointing selection, touched by every processed message
 struct auto_ckpt {
-	/// The inverse of the rollback probability
-	double inv_bad_p;
-	/// The count of straggler and anti-messages
-	unsigned m_bad;
 	/// The count of correctly processed forward messages
 	unsigned m_good;
-	/// The currently selected checkpointing interval
-	unsigned ckpt_interval;
 	/// The count of remaining events to process until the next checkpoint
 	unsigned ckpt_rem;
+	/// The currently selected checkpointing interval
+	unsigned ckpt_interval;
+};
+
+/// The profiling data of the autonomic checkpointing selection, only touched on rollbacks and checkpoints
+struct auto_ckpt_prof {
+	/// The inverse of the rollback probability
+	double inv_bad_p;
+	/// The count of straggler and anti-messages
+	unsigned m_bad;
+	/// The checkpointing cost per byte profiled on this LP, zero if not yet known
+	double ckpt_cost;
+	/// The silent execution cost per event profiled on this LP, zero if not yet known
+	double sil_cost;
+	/// The time spent checkpointing this LP since the last interval computation
+	uint64_t ckpt_time;
+	/// The bytes checkpointed for this LP since the last interval computation
+	uint64_t ckpt_size;
+	/// The time spent in silent execution of this LP since the last interval computation
+	uint64_t sil_time;
+	/// The count of silently executed events of this LP since the last interval computation
+	uint64_t sil_count;
 };
 
 /**
  * Register a "bad" message, i.e. one message which cause a rollback
- * @param auto_ckpt a pointer to the auto-checkpoint module struct of the current LP
+ * @param prof a pointer to the auto-checkpoint profiling data of the current LP
  */
-#define auto_ckpt_register_bad(auto_ckpt) ((auto_ckpt)->m_bad++)
+#define auto_ckpt_register_bad(prof) ((prof)->m_bad++)
 
 /**
  * Register a "good" message, i.e. one message processed in forward execution
@@ -38,6 +54,30 @@ struct auto_ckpt {
  */
 #define auto_ckpt_register_good(auto_ckpt) ((auto_ckpt)->m_good++)
 
+/**
+ * Register a checkpoint taken for the LP
+ * @param prof a pointer to the auto-checkpoint profiling data of the current LP
+ * @param time the time spent to take the checkpoint
+ * @param size the size in bytes of the checkpoint
+ */
+#define auto_ckpt_register_ckpt(prof, time, size)                                                                      \
+	__extension__({                                                                                                \
+		(prof)->ckpt_time += (time);                                                                           \
+		(prof)->ckpt_size += (size);                                                                           \
+	})
+
+/**
+ * Register a silent execution carried out by the LP
+ * @param prof a pointer to the auto-checkpoint profiling data of the current LP
+ * @param time the time spent in the silent execution
+ * @param count the count of silently executed events
+ */
+#define auto_ckpt_register_silent(prof, time, count)                                                                   \
+	__extension__({                                                                                                \
+		(prof)->sil_time += (time);                                                                            \
+		(prof)->sil_count += (count);                                                                          \
+	})
+
 /**
  * Get the currently computed optimal checkpointing interval
  * @param auto_ckpt a pointer to the auto-checkpoint module struct of the current LP
@@ -59,6 +99,6 @@ struct auto_ckpt {
 	})
 
 extern void auto_ckpt_init(void);
-extern void auto_ckpt_lp_init(struct auto_ckpt *auto_ckpt);
+extern void auto_ckpt_lp_init(struct auto_ckpt *auto_ckpt, struct auto_ckpt_prof *prof);
 extern void auto_ckpt_on_gvt(void);
-extern void auto_ckpt_recompute(struct auto_ckpt *auto_ckpt, uint_fast32_t state_size);
+extern void auto_ckpt_recompute(struct auto_ckpt *auto_ckpt, struct auto_ckpt_prof *prof, uint_fast32_t state_size);
@@ -19,6 +19,11 @@ void buddy_init(struct buddy_state *self)
 		self->longest[i] = node_size;
 		node_size -= is_power_of_2(i + 2);
 	}
+	self->tree_ckp = NULL;
+	self->tree_dirty = true;
+#ifdef ROOTSIM_INCREMENTAL
+	memset(self->dirty, 0, sizeof(self->dirty));
+#endif
 }
 
 void *buddy_malloc(struct buddy_state *self, uint_fast8_t req_blks_exp)
@@ -39,6 +44,7 @@ void *buddy_malloc(struct buddy_state *self, uint_fast8_t req_blks_exp)
 
 	/* update the *longest* value back */
 	self->longest[i] = 0;
+	self->tree_dirty = true;
 #ifdef ROOTSIM_INCREMENTAL
 	bitmap_set(self->dirty, i >> B_BLOCK_EXP);
 #endif
@@ -66,6 +72,7 @@ uint_fast32_t buddy_free(struct buddy_state *self, void *ptr)
 		++node_size;
 
 	self->longest[i] = node_size;
+	self->tree_dirty = true;
 	uint_fast32_t ret = (uint_fast32_t)1U << node_size;
 #ifdef ROOTSIM_INCREMENTAL
 	bitmap_set(self->dirty, i >> B_BLOCK_EXP);
@@ -97,6 +104,99 @@ uint_fast32_t buddy_free(struct buddy_state *self, void *ptr)
 	return ret;
 }
 
+/**
+ * @brief Shrink in place an allocated block
+ * @param self the buddy system which contains the block
+ * @param i the index in the longest[] tree of the allocated block
+ * @param node_size the exponent of the current block size
+ * @param req_blks_exp the exponent of the requested block size, smaller than @p node_size
+ *
+ * The block is split until its leftmost descendant has the requested size; the right halves produced along the way
+ * are released. Their subtrees already hold the fully free values, since descendants of an allocated node are never
+ * touched.
+ */
+static void buddy_shrink(struct buddy_state *self, uint_fast32_t i, uint_fast8_t node_size, uint_fast8_t req_blks_exp)
+{
+#ifdef ROOTSIM_INCREMENTAL
+	uint_fast32_t o = (((i + 1) << node_size) - (1 << B_TOTAL_EXP)) >> B_BLOCK_EXP;
+	uint_fast32_t b = (1 << (node_size - B_BLOCK_EXP)) - 1;
+	uint_fast32_t k = (1 << (req_blks_exp - B_BLOCK_EXP));
+	o += (1 << (B_TOTAL_EXP - 2 * B_BLOCK_EXP + 1));
+	// need to track freed blocks content because full checkpoints don't
+	do {
+		bitmap_set(self->dirty, o + b);
+	} while(b-- > k);
+#endif
+
+	self->tree_dirty = true;
+	uint_fast32_t j = i;
+	for(uint_fast8_t l = node_size; l > req_blks_exp; --l) {
+		self->longest[j] = l - 1;
+#ifdef ROOTSIM_INCREMENTAL
+		bitmap_set(self->dirty, j >> B_BLOCK_EXP);
+#endif
+		j = buddy_left_child(j);
+	}
+	self->longest[j] = 0;
+#ifdef ROOTSIM_INCREMENTAL
+	bitmap_set(self->dirty, j >> B_BLOCK_EXP);
+#endif
+
+	while(i) {
+		i = buddy_parent(i);
+		self->longest[i] = max(self->longest[buddy_left_child(i)], self->longest[buddy_right_child(i)]);
+#ifdef ROOTSIM_INCREMENTAL
+		bitmap_set(self->dirty, i >> B_BLOCK_EXP);
+#endif
+	}
+}
+
+/**
+ * @brief Enlarge in place an allocated block, if possible
+ * @param self the buddy system which contains the block
+ * @param i the index in the longest[] tree of the allocated block
+ * @param node_size the exponent of the current block size
+ * @param req_blks_exp the exponent of the requested block size, bigger than @p node_size
+ * @return true if the block has been enlarged, false if the operation wasn't possible
+ *
+ * The block can be enlarged without moving it only if it is the left child of every ancestor up to the target size
+ * and all the right siblings met along the way are completely free.
+ */
+static bool buddy_grow(struct buddy_state *self, uint_fast32_t i, uint_fast8_t node_size, uint_fast8_t req_blks_exp)
+{
+	uint_fast32_t j = i;
+	for(uint_fast8_t l = node_size; l < req_blks_exp; ++l) {
+		// the root and the right children can't be enlarged towards the higher addresses
+		if(!(j & 1U) || self->longest[j + 1] != l)
+			return false;
+		j = buddy_parent(j);
+	}
+
+	// the merged subtree must look completely free below its root
+	self->tree_dirty = true;
+	for(uint_fast8_t l = node_size; l < req_blks_exp; ++l) {
+		self->longest[i] = l;
+#ifdef ROOTSIM_INCREMENTAL
+		bitmap_set(self->dirty, i >> B_BLOCK_EXP);
+#endif
+		i = buddy_parent(i);
+	}
+
+	self->longest[j] = 0;
+#ifdef ROOTSIM_INCREMENTAL
+	bitmap_set(self->dirty, j >> B_BLOCK_EXP);
+#endif
+
+	while(j) {
+		j = buddy_parent(j);
+		self->longest[j] = max(self->longest[buddy_left_child(j)], self->longest[buddy_right_child(j)]);
+#ifdef ROOTSIM_INCREMENTAL
+		bitmap_set(self->dirty, j >> B_BLOCK_EXP);
+#endif
+	}
+	return true;
+}
+
 struct buddy_realloc_res buddy_best_effort_realloc(struct buddy_state *self, void *ptr, size_t req_size)
 {
 	uint_fast8_t node_size = B_BLOCK_EXP;
@@ -111,12 +211,15 @@ struct buddy_realloc_res buddy_best_effort_realloc(struct buddy_state *self, voi
 	struct buddy_realloc_res ret;
 
 	if(node_size == req_blks_exp) {
-		// todo: we can do much better than this
-		//       for example we can always shrink memory allocations cheaply
-		//       we can also enlarge memory allocations without copying if our sibling branches are free
-
 		ret.handled = true;
 		ret.variation = 0;
+	} else if(node_size > req_blks_exp) {
+		buddy_shrink(self, i, node_size, req_blks_exp);
+		ret.handled = true;
+		ret.variation = (int_fast32_t)(1U << req_blks_exp) - (int_fast32_t)(1U << node_size);
+	} else if(req_blks_exp <= B_TOTAL_EXP && buddy_grow(self, i, node_size, req_blks_exp)) {
+		ret.handled = true;
+		ret.variation = (int_fast32_t)(1U << req_blks_exp) - (int_fast32_t)(1U << node_size);
 	} else {
 		ret.handled = false;
 		ret.original = (uint_fast32_t)1U << node_size;
@@ -25,14 +25,16 @@
 #define buddy_left_child(i) (((i) << 1U) + 1U)
 #define buddy_right_child(i) (((i) << 1U) + 2U)
 #define buddy_parent(i) ((((i) + 1) >> 1U) - 1U)
+/// Check if a buddy system has no allocated block
+#define buddy_is_empty(self) ((self)->longest[0] == B_TOTAL_EXP)
+
+struct buddy_tree_checkpoint;
 
 /// The checkpointable memory context of a single buddy system
 struct buddy_state {
 	/// The checkpointed binary tree representing the buddy system
 	/** the last char is actually unused */
 	alignas(16) uint8_t longest[(1U << (B_TOTAL_EXP - B_BLOCK_EXP + 1))];
-	/// The memory buffer served to the model
-	alignas(16) unsigned char base_mem[1U << B_TOTAL_EXP];
 	/// Keeps track of memory blocks which have been dirtied by a write
 	block_bitmap dirty[
 		bitmap_required_size(
@@ -42,14 +44,14 @@ struct buddy_state {
 			(1 << (B_TOTAL_EXP - B_BLOCK_EXP))
 		)
 	];
+	/// The last checkpointed copy of the allocation tree, shared by the checkpoints which found it unchanged
+	struct buddy_tree_checkpoint *tree_ckp;
+	/// Set if the allocation tree has been modified since @a tree_ckp was taken
+	bool tree_dirty;
+	/// The memory buffer served to the model, which is (1 << B_TOTAL_EXP) bytes long and aligned to its size
+	unsigned char *base_mem;
 };
 
-static_assert(
-	offsetof(struct buddy_state, longest) ==
-	offsetof(struct buddy_state, base_mem) -
-	sizeof(((struct buddy_state *)0)->longest),
-	"longest and base_mem are not contiguous, this will break incremental checkpointing");
-
 extern void buddy_init(struct buddy_state *self);
 extern void *buddy_malloc(struct buddy_state *self, uint_fast8_t req_blks_exp);
 extern uint_fast32_t buddy_free(struct buddy_state *self, void *ptr);
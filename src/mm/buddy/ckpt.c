@@ -10,8 +10,23 @@
 
 #include <core/core.h>
 #include <datatypes/array.h>
+#include <mm/dedup.h>
 #include <mm/mm.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/// The minimum length of a run of allocated memory which is saved with non-temporal stores
+#define B_STREAM_COPY_MIN_LEN (1U << 12)
+
+#ifdef ROOTSIM_CKPT_DEDUP
+/// The exponent of the size of the regions of a buddy system which are shared through the deduplication store
+#ifndef B_DEDUP_EXP
+#define B_DEDUP_EXP 12U
+#endif
+static_assert(B_DEDUP_EXP >= B_BLOCK_EXP && B_DEDUP_EXP <= B_TOTAL_EXP, "bad deduplication block size");
+#endif
 
 #define buddy_tree_visit(longest, on_visit)                                                                            \
 	__extension__({                                                                                                \
@@ -42,131 +57,330 @@
 		}                                                                                                      \
 	})
 
-// TODO: fix incremental checkpointing
-#ifdef ROOTSIM_INCREMENTAL
 
-struct buddy_checkpoint *checkpoint_incremental_take(const struct buddy_state *self)
+#ifndef ROOTSIM_CKPT_DEDUP
+/**
+ * @brief Copy a buffer bypassing the cache hierarchy for the destination, when the target supports it
+ * @param dst the destination buffer
+ * @param src the source buffer
+ * @param len the size in bytes of the buffers, at least 16 bytes
+ *
+ * The caller is responsible for issuing a store fence before the copied data is read by another thread.
+ */
+static void stream_copy(unsigned char *restrict dst, const unsigned char *restrict src, size_t len)
 {
-	uint_fast32_t bset = bitmap_count_set(self->dirty, sizeof(self->dirty));
-
-	struct buddy_checkpoint *ret = mm_alloc(offsetof(struct buddy_checkpoint, longest) + bset * (1 << B_BLOCK_EXP));
-
-	unsigned char *ptr = ret->longest;
-	const unsigned char *src = self->longest;
-
-#define copy_block_to_ckp(i)                                                                                           \
-	__extension__({                                                                                                \
-		memcpy(ptr, src + (i << B_BLOCK_EXP), 1 << B_BLOCK_EXP);                                               \
-		ptr += 1 << B_BLOCK_EXP;                                                                               \
-	})
+#ifdef __SSE2__
+	size_t h = (16U - ((uintptr_t)dst & 15U)) & 15U;
+	memcpy(dst, src, h);
+	dst += h;
+	src += h;
+	len -= h;
 
-	bitmap_foreach_set(self->dirty, sizeof(self->dirty), copy_block_to_ckp);
-#undef copy_block_to_ckp
+	while(len >= 64) {
+		__m128i a = _mm_loadu_si128((const __m128i *)src);
+		__m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+		__m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+		__m128i d = _mm_loadu_si128((const __m128i *)(src + 48));
+		_mm_stream_si128((__m128i *)dst, a);
+		_mm_stream_si128((__m128i *)(dst + 16), b);
+		_mm_stream_si128((__m128i *)(dst + 32), c);
+		_mm_stream_si128((__m128i *)(dst + 48), d);
+		dst += 64;
+		src += 64;
+		len -= 64;
+	}
+#endif
+	memcpy(dst, src, len);
+}
+#endif
 
-	memcpy(ret->dirty, self->dirty, sizeof(self->dirty));
-	return ret;
+/**
+ * @brief Drop a reference to a copy of an allocation tree, releasing it if it was the last one
+ * @param t the copy of the allocation tree, possibly NULL
+ */
+static inline void tree_checkpoint_release(struct buddy_tree_checkpoint *t)
+{
+	if(t != NULL && !--t->refs)
+		mm_free(t);
 }
 
-void checkpoint_incremental_restore(struct buddy_state *self, const struct buddy_checkpoint *ckp)
+struct buddy_checkpoint *checkpoint_full_take(struct buddy_state *self, struct buddy_checkpoint *ret)
 {
-	array_count_t i = array_count(self->logs) - 1;
-	const struct buddy_checkpoint *cur_ckp = array_get_at(self->logs, i).c;
+	ret->orig = self;
+#ifdef ROOTSIM_INCREMENTAL
+	memcpy(ret->dirty, self->dirty, sizeof(self->dirty));
+	memset(self->dirty, 0, sizeof(self->dirty));
+#endif
 
-	while(cur_ckp != ckp) {
-		bitmap_merge_or(self->dirty, cur_ckp->dirty, sizeof(self->dirty));
-		cur_ckp = array_get_at(self->logs, --i).c;
-	}
+#ifdef ROOTSIM_CKPT_DEDUP
+	// the allocated bytes of each region are saved as a reference to a shared copy of them
+	unsigned char *ptr = ret->base_mem;
+	unsigned char buf[1U << B_DEDUP_EXP];
+	uint_fast32_t buf_r = 0, buf_len = 0;
+
+#define buddy_dedup_ref_store(data, len)                                                                               \
+	__extension__({                                                                                                \
+		const struct dedup_block *__d = dedup_block_get(data, len);                                            \
+		memcpy(ptr, &__d, sizeof(__d));                                                                        \
+		ptr += sizeof(__d);                                                                                    \
+	})
 
-#define copy_dirty_block(i)                                                                                            \
+#define buddy_dedup_flush()                                                                                            \
 	__extension__({                                                                                                \
-		if(bitmap_check(self->dirty, i)) {                                                                     \
-			memcpy(self->longest + (i << B_BLOCK_EXP), ptr, 1 << B_BLOCK_EXP);                             \
-			bitmap_reset(self->dirty, i);                                                                  \
-			--r;                                                                                           \
+		if(buf_len) {                                                                                          \
+			buddy_dedup_ref_store(buf, buf_len);                                                           \
+			buf_len = 0;                                                                                   \
 		}                                                                                                      \
-		ptr += 1 << B_BLOCK_EXP;                                                                               \
 	})
 
-#define copy_block_from_ckp(i)                                                                                         \
+#define buddy_block_dedup_to_ckp(offset, len)                                                                          \
 	__extension__({                                                                                                \
-		memcpy(self->longest + (i << B_BLOCK_EXP), cur_ckp->longest + (i << B_BLOCK_EXP), 1 << B_BLOCK_EXP);   \
-		--r;                                                                                                   \
+		if((len) >= 1U << B_DEDUP_EXP) {                                                                       \
+			buddy_dedup_flush();                                                                           \
+			for(uint_fast32_t __g = (offset); __g < (offset) + (len); __g += 1U << B_DEDUP_EXP)            \
+				buddy_dedup_ref_store(self->base_mem + __g, 1U << B_DEDUP_EXP);                        \
+		} else {                                                                                               \
+			if((offset) >> B_DEDUP_EXP != buf_r) {                                                         \
+				buddy_dedup_flush();                                                                   \
+				buf_r = (offset) >> B_DEDUP_EXP;                                                       \
+			}                                                                                              \
+			memcpy(buf + buf_len, self->base_mem + (offset), (len));                                       \
+			buf_len += (len);                                                                              \
+		}                                                                                                      \
 	})
 
-#define buddy_block_dirty_from_ckp(offset, len)                                                                        \
+	buddy_tree_visit(self->longest, buddy_block_dedup_to_ckp);
+	buddy_dedup_flush();
+
+#undef buddy_block_dedup_to_ckp
+#undef buddy_dedup_flush
+#undef buddy_dedup_ref_store
+#else
+	// adjacent allocated blocks are coalesced in runs which are copied at once
+	unsigned char *ptr = ret->base_mem;
+	uint_fast32_t run_o = 0, run_len = 0;
+	bool streamed = false;
+
+#define buddy_run_copy_to_ckp()                                                                                        \
 	__extension__({                                                                                                \
-		uint_fast32_t i = (offset >> B_BLOCK_EXP) + (1 << (B_TOTAL_EXP - 2 * B_BLOCK_EXP + 1));                \
-		uint_fast32_t b_len = len;                                                                             \
-		do {                                                                                                   \
-			copy_dirty_block(i);                                                                           \
-			i++;                                                                                           \
-			b_len -= 1U << B_BLOCK_EXP;                                                                    \
-		} while(b_len);                                                                                        \
+		if(run_len >= B_STREAM_COPY_MIN_LEN) {                                                                 \
+			stream_copy(ptr, self->base_mem + run_o, run_len);                                             \
+			streamed = true;                                                                               \
+		} else {                                                                                               \
+			memcpy(ptr, self->base_mem + run_o, run_len);                                                  \
+		}                                                                                                      \
+		ptr += run_len;                                                                                        \
 	})
 
-	uint_fast32_t r = bitmap_count_set(self->dirty, sizeof(self->dirty));
-	const unsigned char *ptr = cur_ckp->longest;
+#define buddy_block_copy_to_ckp(offset, len)                                                                           \
+	__extension__({                                                                                                \
+		if(offset != run_o + run_len) {                                                                        \
+			buddy_run_copy_to_ckp();                                                                       \
+			run_o = offset;                                                                                \
+			run_len = 0;                                                                                   \
+		}                                                                                                      \
+		run_len += len;                                                                                        \
+	})
 
-	bitmap_foreach_set(cur_ckp->dirty, sizeof(cur_ckp->dirty), copy_dirty_block);
+	buddy_tree_visit(self->longest, buddy_block_copy_to_ckp);
+	buddy_run_copy_to_ckp();
 
-	const unsigned tree_bit_size = bitmap_required_size(1 << (B_TOTAL_EXP - 2 * B_BLOCK_EXP + 1));
+#undef buddy_block_copy_to_ckp
+#undef buddy_run_copy_to_ckp
 
-	while(r) {
-		cur_ckp = array_get_at(self->logs, --i).c;
-		if(cur_ckp->is_incremental) {
-			ptr = cur_ckp->longest;
-			bitmap_foreach_set(cur_ckp->dirty, sizeof(cur_ckp->dirty), copy_dirty_block);
-		} else {
-			bitmap_foreach_set(self->dirty, tree_bit_size, copy_block_from_ckp);
-			ptr = cur_ckp->base_mem;
-			buddy_tree_visit(cur_ckp->longest, buddy_block_dirty_from_ckp);
-		}
+#ifdef __SSE2__
+	if(streamed)
+		_mm_sfence();
+#else
+	(void)streamed;
+#endif
+#endif
+
+	if(self->tree_dirty) {
+		tree_checkpoint_release(self->tree_ckp);
+		struct buddy_tree_checkpoint *t = mm_alloc(sizeof(*t));
+		t->refs = 1;
+		t->mem_size = ptr - ret->base_mem;
+		memcpy(t->longest, self->longest, sizeof(t->longest));
+		self->tree_ckp = t;
+		self->tree_dirty = false;
 	}
 
-#undef copy_dirty_block
-#undef copy_block_from_ckp
-#undef buddy_block_dirty_from_ckp
+	++self->tree_ckp->refs;
+	ret->tree = self->tree_ckp;
+	return (struct buddy_checkpoint *)ptr;
 }
 
-#endif
-
-struct buddy_checkpoint *checkpoint_full_take(const struct buddy_state *self, struct buddy_checkpoint *ret)
+const struct buddy_checkpoint *checkpoint_full_restore(struct buddy_state *self, const struct buddy_checkpoint *ckp)
 {
-	ret->orig = self;
-#ifdef ROOTSIM_INCREMENTAL
-	memcpy(ret->dirty, self->dirty, sizeof(self->dirty));
-#endif
-	memcpy(ret->longest, self->longest, sizeof(ret->longest));
+	if(unlikely(ckp->orig != self))
+		return NULL;
 
-#define buddy_block_copy_to_ckp(offset, len)                                                                           \
+	struct buddy_tree_checkpoint *t = ckp->tree;
+	if(self->tree_dirty || self->tree_ckp != t) {
+		memcpy(self->longest, t->longest, sizeof(self->longest));
+		++t->refs;
+		tree_checkpoint_release(self->tree_ckp);
+		self->tree_ckp = t;
+		self->tree_dirty = false;
+	}
+
+	const unsigned char *ptr = ckp->base_mem;
+#ifdef ROOTSIM_CKPT_DEDUP
+	const unsigned char *src = NULL;
+	uint_fast32_t src_r = UINT_FAST32_MAX;
+
+#define buddy_dedup_ref_load()                                                                                         \
 	__extension__({                                                                                                \
-		memcpy(ptr, self->base_mem + offset, len);                                                             \
-		ptr += len;                                                                                            \
+		const struct dedup_block *__d;                                                                         \
+		memcpy(&__d, ptr, sizeof(__d));                                                                        \
+		ptr += sizeof(__d);                                                                                    \
+		__d->data;                                                                                             \
 	})
 
-	unsigned char *ptr = ret->base_mem;
-	buddy_tree_visit(self->longest, buddy_block_copy_to_ckp);
+#define buddy_block_dedup_from_ckp(offset, len)                                                                        \
+	__extension__({                                                                                                \
+		if((len) >= 1U << B_DEDUP_EXP) {                                                                       \
+			for(uint_fast32_t __g = (offset); __g < (offset) + (len); __g += 1U << B_DEDUP_EXP)            \
+				memcpy(self->base_mem + __g, buddy_dedup_ref_load(), 1U << B_DEDUP_EXP);               \
+			src_r = UINT_FAST32_MAX;                                                                       \
+		} else {                                                                                               \
+			if((offset) >> B_DEDUP_EXP != src_r) {                                                         \
+				src = buddy_dedup_ref_load();                                                          \
+				src_r = (offset) >> B_DEDUP_EXP;                                                       \
+			}                                                                                              \
+			memcpy(self->base_mem + (offset), src, (len));                                                 \
+			src += (len);                                                                                  \
+		}                                                                                                      \
+	})
 
-#undef buddy_block_copy_to_ckp
-	return (struct buddy_checkpoint *)ptr;
+	buddy_tree_visit(self->longest, buddy_block_dedup_from_ckp);
+
+#undef buddy_block_dedup_from_ckp
+#undef buddy_dedup_ref_load
+#else
+	uint_fast32_t run_o = 0, run_len = 0;
+
+#define buddy_run_copy_from_ckp()                                                                                      \
+	__extension__({                                                                                                \
+		memcpy(self->base_mem + run_o, ptr, run_len);                                                          \
+		ptr += run_len;                                                                                        \
+	})
+
+#define buddy_block_copy_from_ckp(offset, len)                                                                         \
+	__extension__({                                                                                                \
+		if(offset != run_o + run_len) {                                                                        \
+			buddy_run_copy_from_ckp();                                                                     \
+			run_o = offset;                                                                                \
+			run_len = 0;                                                                                   \
+		}                                                                                                      \
+		run_len += len;                                                                                        \
+	})
+
+	buddy_tree_visit(self->longest, buddy_block_copy_from_ckp);
+	buddy_run_copy_from_ckp();
+
+#undef buddy_block_copy_from_ckp
+#undef buddy_run_copy_from_ckp
+#endif
+#ifdef ROOTSIM_INCREMENTAL
+	memset(self->dirty, 0, sizeof(self->dirty));
+#endif
+	return (const struct buddy_checkpoint *)ptr;
 }
 
-const struct buddy_checkpoint *checkpoint_full_restore(struct buddy_state *self, const struct buddy_checkpoint *ckp)
+#if defined(ROOTSIM_INCREMENTAL) && !defined(ROOTSIM_CKPT_DEDUP)
+
+/// The count of bits of the dirty bitmap which track writes to the allocation tree
+#define B_TREE_DIRTY_BITS (1U << (B_TOTAL_EXP - 2 * B_BLOCK_EXP + 1))
+
+/**
+ * @brief Restore a buddy system from a checkpoint, copying back only the modified tree segments and blocks
+ * @param self the buddy system to restore
+ * @param ckp the checkpoint of the buddy system
+ * @return a pointer to the checkpoint which follows @p ckp in the same buffer, NULL if @p ckp doesn't belong to @p self
+ *
+ * The dirty bitmap of @p self must hold all the writes carried out after @p ckp was taken, i.e. the caller has to
+ * merge in it the dirty bitmaps of the more recent checkpoints which are being discarded.
+ */
+const struct buddy_checkpoint *checkpoint_diff_restore(struct buddy_state *self, const struct buddy_checkpoint *ckp)
 {
 	if(unlikely(ckp->orig != self))
 		return NULL;
 
-	memcpy(self->longest, ckp->longest, sizeof(self->longest));
+	struct buddy_tree_checkpoint *t = ckp->tree;
+	if(self->tree_dirty || self->tree_ckp != t) {
+		for(uint_fast32_t i = 0; i < B_TREE_DIRTY_BITS; ++i)
+			if(bitmap_check(self->dirty, i))
+				memcpy(self->longest + (i << B_BLOCK_EXP), t->longest + (i << B_BLOCK_EXP),
+				    1U << B_BLOCK_EXP);
 
-#define buddy_block_copy_from_ckp(offset, len)                                                                         \
+		++t->refs;
+		tree_checkpoint_release(self->tree_ckp);
+		self->tree_ckp = t;
+		self->tree_dirty = false;
+	}
+
+	if(!bitmap_count_set(self->dirty, sizeof(self->dirty)))
+		return buddy_checkpoint_next(ckp);
+
+	// within each allocated block, the contiguous dirty sub-blocks are copied at once
+#define buddy_block_dirty_from_ckp(offset, len)                                                                        \
 	__extension__({                                                                                                \
-		memcpy(self->base_mem + offset, ptr, len);                                                             \
+		uint_fast32_t __b = B_TREE_DIRTY_BITS + ((offset) >> B_BLOCK_EXP);                                     \
+		uint_fast32_t __n = (len) >> B_BLOCK_EXP, __k = 0;                                                     \
+		while(__k < __n) {                                                                                     \
+			if(!bitmap_check(self->dirty, __b + __k)) {                                                    \
+				++__k;                                                                                 \
+				continue;                                                                              \
+			}                                                                                              \
+			uint_fast32_t __s = __k;                                                                       \
+			while(++__k < __n && bitmap_check(self->dirty, __b + __k))                                     \
+				;                                                                                      \
+			memcpy(self->base_mem + (offset) + (__s << B_BLOCK_EXP), ptr + (__s << B_BLOCK_EXP),           \
+			    (__k - __s) << B_BLOCK_EXP);                                                               \
+		}                                                                                                      \
 		ptr += len;                                                                                            \
 	})
 
 	const unsigned char *ptr = ckp->base_mem;
-	buddy_tree_visit(self->longest, buddy_block_copy_from_ckp);
+	buddy_tree_visit(self->longest, buddy_block_dirty_from_ckp);
 
-#undef buddy_block_copy_from_ckp
+#undef buddy_block_dirty_from_ckp
+	memset(self->dirty, 0, sizeof(self->dirty));
 	return (const struct buddy_checkpoint *)ptr;
 }
+
+#endif
+
+/**
+ * @brief Release the resources referenced by the checkpoint of a buddy system
+ * @param ckp the checkpoint of the buddy system
+ * @return a pointer to the checkpoint which follows @p ckp in the same buffer
+ *
+ * The memory of @p ckp itself is not freed, since it belongs to the enclosing model checkpoint.
+ */
+const struct buddy_checkpoint *checkpoint_full_release(const struct buddy_checkpoint *ckp)
+{
+	const struct buddy_checkpoint *ret = buddy_checkpoint_next(ckp);
+#ifdef ROOTSIM_CKPT_DEDUP
+	for(const unsigned char *ptr = ckp->base_mem; ptr < (const unsigned char *)ret; ptr += sizeof(void *)) {
+		const struct dedup_block *d;
+		memcpy(&d, ptr, sizeof(d));
+		dedup_block_put(d);
+	}
+#endif
+	tree_checkpoint_release(ckp->tree);
+	return ret;
+}
+
+/**
+ * @brief Release the checkpointing resources held by a buddy system
+ * @param self the buddy system
+ */
+void checkpoint_buddy_fini(struct buddy_state *self)
+{
+	tree_checkpoint_release(self->tree_ckp);
+	self->tree_ckp = NULL;
+	self->tree_dirty = true;
+}
@@ -10,11 +10,24 @@
 
 #include <mm/buddy/buddy.h>
 
+/// A copy of the allocation tree of a buddy system, shared by the checkpoints which found it unchanged
+struct buddy_tree_checkpoint {
+	/// The count of checkpoints and buddy systems which reference this copy
+	uint_fast32_t refs;
+	/// The size in bytes of the memory saved by a checkpoint which references this copy
+	uint_fast32_t mem_size;
+	/// The checkpointed binary tree representing the buddy system
+	uint8_t longest[(1U << (B_TOTAL_EXP - B_BLOCK_EXP + 1))];
+};
+
 /// A restorable checkpoint of the memory context of a single buddy system
-struct buddy_checkpoint { // todo only log longest[] if changed, or incrementally
+struct buddy_checkpoint {
 	/// The buddy system to which this checkpoint applies. TODO: reengineer the multi-checkpointing approach
 	const struct buddy_state *orig;
-	/// The checkpoint of the dirty bitmap
+	/// The checkpointed binary tree representing the buddy system
+	struct buddy_tree_checkpoint *tree;
+#ifdef ROOTSIM_INCREMENTAL
+	/// The blocks dirtied since the previous checkpoint
 	block_bitmap dirty [
 		bitmap_required_size(
 		// this tracks writes to the allocation tree...
@@ -23,19 +36,22 @@ struct buddy_checkpoint { // todo only log longest[] if changed, or incrementall
 			(1 << (B_TOTAL_EXP - B_BLOCK_EXP))
 		)
 	];
-	/// The checkpointed binary tree representing the buddy system
-	uint8_t longest[(1U << (B_TOTAL_EXP - B_BLOCK_EXP + 1))];
+#endif
 	/// The checkpointed memory buffer assigned to the model
 	unsigned char base_mem[];
 };
 
-static_assert(
-	offsetof(struct buddy_checkpoint, longest) ==
-	offsetof(struct buddy_checkpoint, base_mem) -
-	sizeof(((struct buddy_checkpoint *)0)->longest),
-	"longest and base_mem are not contiguous, this will break incremental checkpointing");
+/**
+ * @brief Get the checkpoint which follows a given one in the same buffer
+ * @param ckp the checkpoint of a buddy system
+ * @return a pointer to the checkpoint which follows @p ckp
+ */
+#define buddy_checkpoint_next(ckp) ((const struct buddy_checkpoint *)((ckp)->base_mem + (ckp)->tree->mem_size))
 
-extern struct buddy_checkpoint *checkpoint_full_take(const struct buddy_state *self, struct buddy_checkpoint *data);
+extern struct buddy_checkpoint *checkpoint_full_take(struct buddy_state *self, struct buddy_checkpoint *data);
 extern const struct buddy_checkpoint *checkpoint_full_restore(struct buddy_state *self, const struct buddy_checkpoint *data);
-extern struct buddy_checkpoint *checkpoint_incremental_take(const struct buddy_state *self, struct buddy_checkpoint *data);
-extern const struct buddy_checkpoint * checkpoint_incremental_restore(struct buddy_state *self, const struct buddy_checkpoint *ckp);
+extern const struct buddy_checkpoint *checkpoint_full_release(const struct buddy_checkpoint *ckp);
+extern void checkpoint_buddy_fini(struct buddy_state *self);
+#if defined(ROOTSIM_INCREMENTAL) && !defined(ROOTSIM_CKPT_DEDUP)
+extern const struct buddy_checkpoint *checkpoint_diff_restore(struct buddy_state *self, const struct buddy_checkpoint *ckp);
+#endif
@@ -13,35 +13,547 @@
 #include <lp/lp.h>
 #include <mm/buddy/buddy.h>
 #include <mm/buddy/ckpt.h>
+#include <mm/paging.h>
 
 #include <errno.h>
 
+/// The exponent of the size of each address range reserved by a thread to host its buddy systems
+#ifndef B_ARENA_EXP
+#define B_ARENA_EXP (sizeof(void *) > 4 ? 36U : 26U)
+#endif
+/// The exponent of the size of the arena slot of a buddy system, which holds just the memory served to the model
+#define B_SLOT_EXP B_TOTAL_EXP
+/// The count of slots which are committed at once when the arena needs to grow
+#define B_ARENA_COMMIT_SLOTS 32U
+/// The count of released slots which are kept resident for a quick reuse, the memory of the others is discarded
+#define B_ARENA_POOL_HOT 16U
+/// The exponent of the granularity which the bookkeeping of the buddy systems is committed with
+#define B_META_COMMIT_EXP 16U
+
+/// The size in bytes of an arena range, which is also its alignment
+#define B_RANGE_SIZE ((size_t)1U << B_ARENA_EXP)
+/// The size in bytes of the slots committed at once
+#define B_ARENA_COMMIT_SIZE ((size_t)B_ARENA_COMMIT_SLOTS << B_SLOT_EXP)
+/// The size in bytes of the bookkeeping at the start of an arena range, rounded to a whole commit step
+#define B_RANGE_META_SIZE                                                                                              \
+	((((sizeof(struct buddy_state) << (B_ARENA_EXP - B_SLOT_EXP)) - 1) | (B_ARENA_COMMIT_SIZE - 1)) + 1)
+
+static_assert(B_RANGE_META_SIZE < B_RANGE_SIZE, "the arena range is too small to host any buddy system");
+
+/// The ranges of virtual addresses which host the buddy systems of the LPs bound to the current thread
+/** Each range starts with the bookkeeping of the buddy systems, an entry for each slot of the range, followed by the
+ * slots themselves. A new range is chained when the last one is full. */
+static __thread struct {
+	/// The reserved ranges, as returned by mem_region_reserve(), the last one being the one in use
+	dyn_array(void *) raws;
+	/// The start of the range in use, aligned to the range size, NULL if no range has been reserved yet
+	unsigned char *range;
+	/// The first never used slot of the range in use
+	unsigned char *top;
+	/// The end of the committed slots of the range in use
+	unsigned char *committed;
+	/// The end of the committed bookkeeping of the range in use
+	unsigned char *meta_committed;
+	/// The list of released buddy systems, which is the pool reused by the LPs of the thread
+	void *free_list;
+	/// The count of buddy systems in @a free_list
+	uint_fast32_t pooled;
+	/// The count of buddy systems currently in use
+	uint_fast32_t used;
+} b_arena;
+
+/**
+ * @brief Get the arena range which contains a given address
+ * @param ptr a pointer to some memory in an arena range
+ * @return the start of the range which contains @p ptr
+ */
+#define buddy_range_of(ptr) ((unsigned char *)((uintptr_t)(ptr) & ~(uintptr_t)(B_RANGE_SIZE - 1)))
+
+/**
+ * @brief Get the start of an arena range
+ * @param raw the reserved range, as returned by mem_region_reserve()
+ * @return the start of the range, aligned to the range size
+ */
+#define buddy_range_from_raw(raw) buddy_range_of((uintptr_t)(raw) + B_RANGE_SIZE - 1)
+
+/**
+ * @brief Get the buddy system which contains a given address
+ * @param ptr a pointer to some memory served by a buddy system of the current thread
+ * @return the buddy system which serves @p ptr
+ *
+ * The ranges are aligned to their size, so the bookkeeping entry is found by masking the pointer, whichever range
+ * holds it.
+ */
+#define buddy_find_by_address(ptr)                                                                                     \
+	((struct buddy_state *)buddy_range_of(ptr) + (((uintptr_t)(ptr) & (B_RANGE_SIZE - 1)) >> B_SLOT_EXP))
+
+/// The exponent of the size of the huge pages
+#define B_HUGE_PAGE_EXP 21U
+
+static_assert(B_ARENA_COMMIT_SIZE % (1U << B_HUGE_PAGE_EXP) == 0, "the arena is not committed in whole huge pages");
+
+/**
+ * @brief Reserve a new range for the thread buddy systems arena, which becomes the one in use
+ *
+ * The range is reserved with twice its size, so that it can be aligned to its size: this only costs address space.
+ */
+static void buddy_arena_range_add(void)
+{
+	void *raw = mem_region_reserve(2 * B_RANGE_SIZE);
+	if(unlikely(raw == NULL)) {
+		logger(LOG_FATAL, "Unable to reserve the address range for the model memory!");
+		abort();
+	}
+
+	if(b_arena.range == NULL)
+		array_init(b_arena.raws);
+	array_push(b_arena.raws, raw);
+
+	b_arena.range = buddy_range_from_raw(raw);
+	b_arena.top = b_arena.range + B_RANGE_META_SIZE;
+	b_arena.committed = b_arena.top;
+	// the bookkeeping entries of the slots taken by the bookkeeping itself are never used, nor committed
+	b_arena.meta_committed = (unsigned char *)((uintptr_t)buddy_find_by_address(b_arena.top) &
+	                                           ~(((uintptr_t)1U << B_META_COMMIT_EXP) - 1));
+
+	if(global_config.huge_pages && mem_region_huge_advise(b_arena.top, B_RANGE_SIZE - B_RANGE_META_SIZE) &&
+	    array_count(b_arena.raws) == 1)
+		logger(LOG_WARN, "Huge pages are not available, the model memory will use regular pages");
+}
+
+/**
+ * @brief Enlarge the committed part of the thread buddy systems arena, chaining a new range if needed
+ *
+ * If huge pages have been requested, the newly committed part is pre-faulted here: this is always called by the
+ * worker thread which owns the arena, so that the memory is first touched by the thread which is going to use it.
+ * The bookkeeping of the buddy systems lives apart from their slots, so that a huge page is filled with the memory of
+ * the models only.
+ */
+static void buddy_arena_grow(void)
+{
+	if(unlikely(b_arena.range == NULL || b_arena.committed == b_arena.range + B_RANGE_SIZE))
+		buddy_arena_range_add();
+
+	size_t c = B_ARENA_COMMIT_SIZE;
+	unsigned char *m = (unsigned char *)(buddy_find_by_address(b_arena.committed + c - 1) + 1);
+	size_t mc = m > b_arena.meta_committed ? (size_t)(m - b_arena.meta_committed) : 0;
+	mc = mc > 0 ? (((mc - 1) >> B_META_COMMIT_EXP) + 1) << B_META_COMMIT_EXP : 0;
+	if(unlikely(mem_region_commit(b_arena.committed, c) || (mc && mem_region_commit(b_arena.meta_committed, mc)))) {
+		logger(LOG_FATAL, "Out of memory!");
+		abort();
+	}
+
+	if(global_config.huge_pages) {
+		mem_region_prefault(b_arena.committed, c);
+		if(mc)
+			mem_region_prefault(b_arena.meta_committed, mc);
+	}
+
+	b_arena.committed += c;
+	b_arena.meta_committed += mc;
+}
+
+/**
+ * @brief Give back to the OS the whole thread buddy systems arena
+ */
+static void buddy_arena_release(void)
+{
+	for(array_count_t i = 0; i < array_count(b_arena.raws); ++i)
+		mem_region_release(array_get_at(b_arena.raws, i), 2 * B_RANGE_SIZE);
+	array_fini(b_arena.raws);
+	memset(&b_arena, 0, sizeof(b_arena));
+}
+
+/**
+ * @brief Check if an address belongs to the slots of the thread buddy systems arena
+ * @param ptr the address to check
+ * @return true if @p ptr points inside a slot handed out to a buddy system of the current thread, false otherwise
+ */
+static bool buddy_arena_owns(const void *ptr)
+{
+	unsigned char *r = buddy_range_of(ptr);
+	if(((uintptr_t)ptr & (B_RANGE_SIZE - 1)) < B_RANGE_META_SIZE)
+		return false;
+
+	if(likely(r == b_arena.range))
+		return (const unsigned char *)ptr < b_arena.top;
+
+	for(array_count_t i = 0; i + 1 < array_count(b_arena.raws); ++i)
+		if(buddy_range_from_raw(array_get_at(b_arena.raws, i)) == r)
+			return true;
+
+	return false;
+}
+
+/**
+ * @brief Allocate a new buddy system from the thread arena
+ * @return a pointer to the uninitialized buddy system
+ */
+static struct buddy_state *buddy_state_alloc(void)
+{
+	struct buddy_state *ret = b_arena.free_list;
+	if(likely(ret != NULL)) {
+		b_arena.free_list = *(void **)ret;
+		--b_arena.pooled;
+	} else {
+		if(unlikely(b_arena.top == b_arena.committed))
+			buddy_arena_grow();
+		ret = buddy_find_by_address(b_arena.top);
+		ret->base_mem = b_arena.top;
+		b_arena.top += 1U << B_SLOT_EXP;
+	}
+	++b_arena.used;
+	return ret;
+}
+
+/**
+ * @brief Release a buddy system to the thread arena
+ * @param b the buddy system to release
+ *
+ * Past the first @a B_ARENA_POOL_HOT pooled slots, the memory of the served buffer is given back to the OS, unless
+ * huge pages are in use. The whole arena is given back to the OS when its last buddy system is released.
+ */
+static void buddy_state_free(struct buddy_state *b)
+{
+	*(void **)b = b_arena.free_list;
+	b_arena.free_list = b;
+	++b_arena.pooled;
+
+	if(likely(--b_arena.used)) {
+		if(b_arena.pooled > B_ARENA_POOL_HOT && !global_config.huge_pages)
+			mem_region_discard(b->base_mem, (size_t)1U << B_TOTAL_EXP);
+		return;
+	}
+
+	buddy_arena_release();
+}
+
+/// The exponent of the size of the allocation granules of the compact chunks
+#define C_GRANULE_EXP 4U
+/// The count of granules in a compact chunk, bounded by the width of the allocation bitmaps
+#define C_CHUNK_GRANULES 64U
+/// The size in bytes of a compact chunk, which is also the largest allocation served by it
+#define C_CHUNK_SIZE (C_CHUNK_GRANULES << C_GRANULE_EXP)
+/// The count of compact chunks carved out of each slab
+#define C_SLAB_CHUNKS 64U
+
+/// A slab of compact chunks, shared by the LPs bound to a thread
+struct compact_slab {
+	/// The previously allocated slab
+	struct compact_slab *next;
+	/// The compact chunks of this slab
+	alignas(1U << C_GRANULE_EXP) unsigned char chunks[C_SLAB_CHUNKS][C_CHUNK_SIZE];
+};
+
+/// The slabs which host the compact chunks of the LPs bound to the current thread
+static __thread struct {
+	/// The list of allocated slabs
+	struct compact_slab *slabs;
+	/// The list of released chunks
+	void *free_list;
+	/// The count of never used chunks in the last allocated slab
+	uint_fast32_t left;
+	/// The count of chunks currently in use
+	uint_fast32_t used;
+} c_arena;
+
+/**
+ * @brief Check if an address has been served by the compact chunk of a memory context
+ * @param self the memory context
+ * @param ptr the address to check
+ * @return true if @p ptr lies in the compact chunk of @p self, false otherwise
+ */
+#define compact_owns(self, ptr) ((uintptr_t)(ptr) - (uintptr_t)(self)->c_chunk < C_CHUNK_SIZE)
+
+/**
+ * @brief Compute the bitmap of a run of granules
+ * @param g the index of the first granule of the run
+ * @param n the count of granules in the run
+ * @return the bitmap with set bits in correspondence of the granules of the run
+ */
+#define compact_run_mask(g, n) (((n) == C_CHUNK_GRANULES ? ~UINT64_C(0) : (UINT64_C(1) << (n)) - 1) << (g))
+
+/**
+ * @brief Compute the length of a run of set bits
+ * @param bits the bitmap to inspect
+ * @param g the index of the first bit of the run, which must be set
+ * @return the count of consecutive set bits starting from the @p g-th one
+ */
+static inline unsigned compact_run_len(uint64_t bits, unsigned g)
+{
+	uint64_t r = ~(bits >> g);
+	return r ? (unsigned)intrinsics_ctz(r) : C_CHUNK_GRANULES - g;
+}
+
+/**
+ * @brief Compute the count of granules of an allocation served by a compact chunk
+ * @param self the memory context which owns the compact chunk
+ * @param g the index of the first granule of the allocation
+ * @return the count of granules of the allocation
+ */
+static unsigned compact_alloc_len(const struct mm_state *self, unsigned g)
+{
+	uint64_t s = self->c_starts >> g >> 1;
+	unsigned n = s ? (unsigned)intrinsics_ctz(s) + 1 : C_CHUNK_GRANULES - g;
+	return min(n, compact_run_len(self->c_used, g));
+}
+
+/**
+ * @brief Free all the thread compact slabs
+ */
+static void compact_arena_release(void)
+{
+	while(c_arena.slabs != NULL) {
+		struct compact_slab *slab = c_arena.slabs;
+		c_arena.slabs = slab->next;
+		mm_free(slab);
+	}
+	memset(&c_arena, 0, sizeof(c_arena));
+}
+
+/**
+ * @brief Get a compact chunk from the thread slabs
+ * @return a pointer to the uninitialized chunk
+ */
+static unsigned char *compact_chunk_alloc(void)
+{
+	++c_arena.used;
+	void *ret = c_arena.free_list;
+	if(likely(ret != NULL)) {
+		c_arena.free_list = *(void **)ret;
+		return ret;
+	}
+
+	if(unlikely(!c_arena.left)) {
+		struct compact_slab *slab = mm_alloc(sizeof(*slab));
+		slab->next = c_arena.slabs;
+		c_arena.slabs = slab;
+		c_arena.left = C_SLAB_CHUNKS;
+	}
+	return c_arena.slabs->chunks[--c_arena.left];
+}
+
+/**
+ * @brief Release a compact chunk to the thread slabs
+ * @param chunk the chunk to release
+ *
+ * The slabs are freed when their last chunk is released.
+ */
+static void compact_chunk_free(unsigned char *chunk)
+{
+	*(void **)chunk = c_arena.free_list;
+	c_arena.free_list = chunk;
+
+	if(likely(--c_arena.used))
+		return;
+
+	compact_arena_release();
+}
+
+/**
+ * @brief Allocate some memory from the compact chunk of a memory context
+ * @param self the memory context
+ * @param req_size the size in bytes of the allocation, which must not be greater than @a C_CHUNK_SIZE
+ * @return a pointer to the allocated memory, or NULL if the compact chunk can't fit the request
+ */
+static void *compact_malloc(struct mm_state *self, size_t req_size)
+{
+	unsigned n = (req_size + (1U << C_GRANULE_EXP) - 1) >> C_GRANULE_EXP;
+	// the set bits of m mark the granules starting a run of n free ones
+	uint64_t m = ~self->c_used;
+	for(unsigned i = 1; i < n && m; ++i)
+		m &= ~self->c_used >> i;
+
+	if(unlikely(!m))
+		return NULL;
+
+	if(unlikely(self->c_chunk == NULL))
+		self->c_chunk = compact_chunk_alloc();
+
+	unsigned g = intrinsics_ctz(m);
+	self->c_used |= compact_run_mask(g, n);
+	self->c_starts |= UINT64_C(1) << g;
+	self->full_ckpt_size += n << C_GRANULE_EXP;
+	return self->c_chunk + (g << C_GRANULE_EXP);
+}
+
+/**
+ * @brief Free some memory served by the compact chunk of a memory context
+ * @param self the memory context
+ * @param ptr a pointer to the memory to free
+ */
+static void compact_free(struct mm_state *self, void *ptr)
+{
+	unsigned g = ((unsigned char *)ptr - self->c_chunk) >> C_GRANULE_EXP;
+	unsigned n = compact_alloc_len(self, g);
+	self->c_used &= ~compact_run_mask(g, n);
+	self->c_starts &= ~(UINT64_C(1) << g);
+	self->full_ckpt_size -= n << C_GRANULE_EXP;
+}
+
+/**
+ * @brief Copy the allocated granules of a compact chunk
+ * @param dst the destination of the copies
+ * @param src the source of the copies
+ * @param used the allocation bitmap of the compact chunk
+ * @param to_ckp true if @p src is the compact chunk and @p dst the checkpoint, false if the converse holds
+ * @return a pointer to the first byte past the copied granules in the checkpoint
+ *
+ * In the checkpoint the allocated granules are stored contiguously, so that only the bytes of the LP are saved.
+ */
+static unsigned char *compact_copy(unsigned char *dst, const unsigned char *src, uint64_t used, bool to_ckp)
+{
+	while(used) {
+		unsigned g = intrinsics_ctz(used);
+		unsigned n = compact_run_len(used, g);
+		used &= ~compact_run_mask(g, n);
+		size_t off = (size_t)g << C_GRANULE_EXP, len = (size_t)n << C_GRANULE_EXP;
+		if(to_ckp) {
+			memcpy(dst, src + off, len);
+			dst += len;
+		} else {
+			memcpy(dst + off, src, len);
+			src += len;
+		}
+	}
+	return to_ckp ? dst : (unsigned char *)src;
+}
+
+/**
+ * @brief Get the checkpoints of the buddy systems in a model memory checkpoint
+ * @param ckp the model memory checkpoint
+ * @return a pointer to the first buddy system checkpoint in @p ckp
+ */
+#define mm_checkpoint_buddies(ckp)                                                                                     \
+	((struct buddy_checkpoint *)((ckp)->chkps + ((size_t)intrinsics_popcount((ckp)->c_used) << C_GRANULE_EXP)))
+
+/**
+ * @brief Compute the size of a model memory checkpoint
+ * @param ckp the model memory checkpoint
+ * @return the size in bytes of @p ckp, up to the end of its last buddy system checkpoint
+ */
+static size_t mm_checkpoint_size(const struct mm_checkpoint *ckp)
+{
+	const struct buddy_checkpoint *c = mm_checkpoint_buddies(ckp);
+	while(c->orig != NULL)
+		c = buddy_checkpoint_next(c);
+	return (const unsigned char *)c + sizeof(c->orig) - (const unsigned char *)ckp;
+}
+
 #ifdef ROOTSIM_INCREMENTAL
 #define is_log_incremental(l) ((uintptr_t)(l).c & 0x1)
 #else
 #define is_log_incremental(l) false
 #endif
 
+#if defined(ROOTSIM_INCREMENTAL) && !defined(ROOTSIM_CKPT_DEDUP)
+/// If the model reports its writes, only the modified parts of the buddy systems are restored
+#define checkpoint_restore(b, c)                                                                                       \
+	(global_config.write_tracking ? checkpoint_diff_restore(b, c) : checkpoint_full_restore(b, c))
+#else
+#define checkpoint_restore checkpoint_full_restore
+#endif
+
+/**
+ * @brief Free a model memory checkpoint along with the resources it references
+ * @param ckp the checkpoint to free
+ */
+static void mm_checkpoint_free(struct mm_checkpoint *ckp)
+{
+	const struct buddy_checkpoint *buddy_ckp = mm_checkpoint_buddies(ckp);
+	while(buddy_ckp->orig != NULL)
+		buddy_ckp = checkpoint_full_release(buddy_ckp);
+	mm_free(ckp->bump);
+	mm_free(ckp);
+}
+
+/**
+ * @brief Check if a buddy system is referenced by some of the retained checkpoints of a memory context
+ * @param self the memory context
+ * @param b the buddy system
+ * @return true if some checkpoint of @p self holds a copy of @p b, false otherwise
+ */
+static bool mm_logs_reference(const struct mm_state *self, const struct buddy_state *b)
+{
+	array_count_t i = array_count(self->logs);
+	while(i--) {
+		const struct buddy_checkpoint *c = mm_checkpoint_buddies(array_get_at(self->logs, i).c);
+		for(; c->orig != NULL; c = buddy_checkpoint_next(c))
+			if(c->orig == b)
+				return true;
+	}
+	return false;
+}
+
+/**
+ * @brief Release to the thread pool the empty buddy systems which no retained checkpoint references
+ * @param self the memory context
+ *
+ * The order of the remaining buddy systems is preserved, since restores match them with their checkpoints in order.
+ */
+static void mm_buddies_reclaim(struct mm_state *self)
+{
+	array_count_t i = array_count(self->buddies);
+	while(i--) {
+		struct buddy_state *b = array_get_at(self->buddies, i);
+		if(likely(!buddy_is_empty(b)) || mm_logs_reference(self, b))
+			continue;
+
+		array_remove_at(self->buddies, i);
+		checkpoint_buddy_fini(b);
+		buddy_state_free(b);
+		self->full_ckpt_size -= offsetof(struct buddy_checkpoint, base_mem);
+	}
+}
+
 void model_allocator_lp_init(struct mm_state *self)
 {
 	array_init(self->buddies);
 	array_init(self->logs);
 	self->full_ckpt_size = offsetof(struct mm_checkpoint, chkps) + sizeof(struct buddy_state *);
+	self->c_chunk = NULL;
+	self->c_used = 0;
+	self->c_starts = 0;
+	self->c_promoted = false;
+	self->paged = NULL;
+	bump_arena_init(&self->bump);
 }
 
 void model_allocator_lp_fini(struct mm_state *self)
 {
 	array_count_t i = array_count(self->logs);
 	while(i--)
-		mm_free(array_get_at(self->logs, i).c);
+		mm_checkpoint_free(array_get_at(self->logs, i).c);
 
 	array_fini(self->logs);
 
 	i = array_count(self->buddies);
-	while(i--)
-		mm_free(array_get_at(self->buddies, i));
+	while(i--) {
+		struct buddy_state *b = array_get_at(self->buddies, i);
+		checkpoint_buddy_fini(b);
+		buddy_state_free(b);
+	}
 
 	array_fini(self->buddies);
+
+	if(self->c_chunk != NULL)
+		compact_chunk_free(self->c_chunk);
+
+	bump_arena_fini(&self->bump);
+}
+
+/**
+ * @brief Give back in bulk the memory of the LPs bound to the calling thread
+ *
+ * This is used in place of model_allocator_lp_fini() when the process is about to exit: the buddy systems arena is
+ * released at once, while the checkpoints and the bookkeeping arrays of the LPs are simply left to the OS.
+ */
+void model_allocator_thread_drop(void)
+{
+	if(b_arena.range != NULL)
+		buddy_arena_release();
+
+	compact_arena_release();
 }
 
 void *rs_malloc(size_t req_size)
@@ -49,6 +561,15 @@ void *rs_malloc(size_t req_size)
 	if(unlikely(!req_size))
 		return NULL;
 
+	struct mm_state *self = &lp_cold(current_lp)->mm_state;
+	if(likely(!self->c_promoted && req_size <= C_CHUNK_SIZE)) {
+		void *ret = compact_malloc(self, req_size);
+		if(likely(ret != NULL))
+			return ret;
+		// the LP outgrew its compact chunk: the allocations already there stay put, the new ones go elsewhere
+		self->c_promoted = true;
+	}
+
 	uint_fast8_t req_blks_exp = buddy_allocation_block_compute(req_size);
 	if(unlikely(req_blks_exp > B_TOTAL_EXP)) {
 		errno = ENOMEM;
@@ -56,7 +577,6 @@ void *rs_malloc(size_t req_size)
 		return NULL;
 	}
 
-	struct mm_state *self = &current_lp->mm_state;
 	self->full_ckpt_size += 1 << req_blks_exp;
 
 	array_count_t i = array_count(self->buddies);
@@ -66,14 +586,10 @@ void *rs_malloc(size_t req_size)
 			return ret;
 	}
 
-	struct buddy_state *new_buddy = mm_alloc(sizeof(*new_buddy));
+	struct buddy_state *new_buddy = buddy_state_alloc();
 	buddy_init(new_buddy);
 
-	for(i = 0; i < array_count(self->buddies); ++i)
-		if(array_get_at(self->buddies, i) > new_buddy)
-			break;
-
-	array_add_at(self->buddies, i, new_buddy);
+	array_push(self->buddies, new_buddy);
 	self->full_ckpt_size += offsetof(struct buddy_checkpoint, base_mem);
 	return buddy_malloc(new_buddy, req_blks_exp);
 }
@@ -83,34 +599,28 @@ void *rs_calloc(size_t nmemb, size_t size)
 	size_t tot = nmemb * size;
 	void *ret = rs_malloc(tot);
 
-	if(likely(ret))
+	if(likely(ret)) {
 		memset(ret, 0, tot);
+#ifdef ROOTSIM_INCREMENTAL
+		__write_mem(ret, tot);
+#endif
+	}
 
 	return ret;
 }
 
-static inline struct buddy_state *buddy_find_by_address(struct mm_state *self, const void *ptr)
-{
-	array_count_t l = 0, h = array_count(self->buddies) - 1;
-	while(1) {
-		array_count_t m = (l + h) / 2;
-		struct buddy_state *b = array_get_at(self->buddies, m);
-		if(ptr < (void *)b)
-			h = m - 1;
-		else if(ptr > (void *)(b + 1))
-			l = m + 1;
-		else
-			return b;
-	}
-}
-
 void rs_free(void *ptr)
 {
 	if(unlikely(!ptr))
 		return;
 
-	struct mm_state *self = &current_lp->mm_state;
-	struct buddy_state *b = buddy_find_by_address(self, ptr);
+	struct mm_state *self = &lp_cold(current_lp)->mm_state;
+	if(unlikely(compact_owns(self, ptr))) {
+		compact_free(self, ptr);
+		return;
+	}
+
+	struct buddy_state *b = buddy_find_by_address(ptr);
 	self->full_ckpt_size -= buddy_free(b, ptr);
 }
 
@@ -124,36 +634,51 @@ void *rs_realloc(void *ptr, size_t req_size)
 	if(!ptr)
 		return rs_malloc(req_size);
 
-	struct mm_state *self = &current_lp->mm_state;
-	struct buddy_state *b = buddy_find_by_address(self, ptr);
-	struct buddy_realloc_res ret = buddy_best_effort_realloc(b, ptr, req_size);
-	if(ret.handled) {
-		self->full_ckpt_size += ret.variation;
-		return ptr;
+	struct mm_state *self = &lp_cold(current_lp)->mm_state;
+	size_t original;
+	if(unlikely(compact_owns(self, ptr))) {
+		unsigned g = ((unsigned char *)ptr - self->c_chunk) >> C_GRANULE_EXP;
+		original = (size_t)compact_alloc_len(self, g) << C_GRANULE_EXP;
+		if(req_size <= original)
+			return ptr;
+	} else {
+		struct buddy_state *b = buddy_find_by_address(ptr);
+		struct buddy_realloc_res ret = buddy_best_effort_realloc(b, ptr, req_size);
+		if(ret.handled) {
+			self->full_ckpt_size += ret.variation;
+			return ptr;
+		}
+		original = ret.original;
 	}
 
 	void *new_buffer = rs_malloc(req_size);
 	if(unlikely(new_buffer == NULL))
 		return NULL;
 
-	memcpy(new_buffer, ptr, min(req_size, ret.original));
+	memcpy(new_buffer, ptr, min(req_size, original));
+#ifdef ROOTSIM_INCREMENTAL
+	__write_mem(new_buffer, min(req_size, original));
+#endif
 	rs_free(ptr);
 
 	return new_buffer;
 }
 
+/**
+ * @brief Report a write to the memory of the current LP
+ * @param ptr a pointer to the first written byte
+ * @param s the count of written bytes
+ *
+ * Models which set the @a write_tracking configuration flag must report through this function every write to the
+ * memory they got from rs_malloc(), rs_calloc() and rs_realloc(), before the end of the event which carries it out.
+ * The writes to memory not served by the buddy systems are ignored.
+ */
 void __write_mem(const void *ptr, size_t s)
 {
-	struct mm_state *self = &current_lp->mm_state;
-	if(unlikely(!s || array_is_empty(self->buddies)))
-		return;
-
-	if(unlikely(ptr < (void *)array_get_at(self->buddies, 0) || ptr > (void *)(array_peek(self->buddies) + 1)))
+	if(unlikely(!s || !buddy_arena_owns(ptr)))
 		return;
 
-	struct buddy_state *b = buddy_find_by_address(self, ptr);
-
-	buddy_dirty_mark(b, ptr, s);
+	buddy_dirty_mark(buddy_find_by_address(ptr), ptr, s);
 }
 
 // todo: incremental
@@ -161,15 +686,31 @@ void model_allocator_checkpoint_take(struct mm_state *self, array_count_t ref_i)
 {
 	struct mm_checkpoint *ckp = mm_alloc(self->full_ckpt_size);
 	ckp->ckpt_size = self->full_ckpt_size;
+	ckp->c_used = self->c_used;
+	ckp->c_starts = self->c_starts;
+	ckp->bump = bump_checkpoint_take(&self->bump);
 
-	struct mm_log mm_log = {.ref_i = ref_i, .c = ckp};
-	array_push(self->logs, mm_log);
-
-	struct buddy_checkpoint *buddy_ckp = (struct buddy_checkpoint *)ckp->chkps;
+	struct buddy_checkpoint *buddy_ckp =
+	    (struct buddy_checkpoint *)compact_copy(ckp->chkps, self->c_chunk, self->c_used, true);
 	array_count_t i = array_count(self->buddies);
-	while(i--)
-		buddy_ckp = checkpoint_full_take(array_get_at(self->buddies, i), buddy_ckp);
+	while(i--) {
+		struct buddy_state *b = array_get_at(self->buddies, i);
+		// empty buddy systems are left out: restoring this checkpoint resets them anyway
+		if(unlikely(buddy_is_empty(b))) {
+			ckp->ckpt_size -= offsetof(struct buddy_checkpoint, base_mem);
+			continue;
+		}
+		buddy_ckp = checkpoint_full_take(b, buddy_ckp);
+	}
 	buddy_ckp->orig = NULL;
+
+#ifdef ROOTSIM_CKPT_DEDUP
+	// the buddy systems only saved references to their shared blocks, which are much smaller than the blocks
+	ckp = mm_realloc(ckp, (unsigned char *)buddy_ckp + sizeof(buddy_ckp->orig) - (unsigned char *)ckp);
+#endif
+
+	struct mm_log mm_log = {.ref_i = ref_i, .c = ckp};
+	array_push(self->logs, mm_log);
 }
 
 void model_allocator_checkpoint_next_force_full(struct mm_state *self)
@@ -184,24 +725,45 @@ array_count_t model_allocator_checkpoint_restore(struct mm_state *self, array_co
 	while(array_get_at(self->logs, i).ref_i > ref_i)
 		i--;
 
+#if defined(ROOTSIM_INCREMENTAL) && !defined(ROOTSIM_CKPT_DEDUP)
+	// the buddy systems must be aware of all the writes carried out after the target checkpoint
+	for(array_count_t j = array_count(self->logs) - 1; global_config.write_tracking && j > i; --j) {
+		const struct buddy_checkpoint *c = mm_checkpoint_buddies(array_get_at(self->logs, j).c);
+		for(; c->orig != NULL; c = buddy_checkpoint_next(c)) {
+			struct buddy_state *b = (struct buddy_state *)c->orig;
+			bitmap_merge_or(b->dirty, c->dirty, sizeof(b->dirty));
+		}
+	}
+#endif
+
 	struct mm_checkpoint *ckp = array_get_at(self->logs, i).c;
 	self->full_ckpt_size = ckp->ckpt_size;
-	const struct buddy_checkpoint *buddy_ckp = (struct buddy_checkpoint *)ckp->chkps;
+	self->c_used = ckp->c_used;
+	self->c_starts = ckp->c_starts;
+	const struct buddy_checkpoint *buddy_ckp =
+	    (struct buddy_checkpoint *)compact_copy(self->c_chunk, ckp->chkps, ckp->c_used, false);
 
 	array_count_t k = array_count(self->buddies);
 	while(k--) {
 		struct buddy_state *b = array_get_at(self->buddies, k);
-		const struct buddy_checkpoint *c = checkpoint_full_restore(array_get_at(self->buddies, k), buddy_ckp);
+		const struct buddy_checkpoint *c = checkpoint_restore(b, buddy_ckp);
 		if(unlikely(c == NULL)) {
+			checkpoint_buddy_fini(b);
 			buddy_init(b);
+#ifdef ROOTSIM_INCREMENTAL
+			// the memory is now unrelated to the older checkpoints, which have to restore all of it
+			memset(b->dirty, 0xff, sizeof(b->dirty));
+#endif
 			self->full_ckpt_size += offsetof(struct buddy_checkpoint, base_mem);
 		} else {
 			buddy_ckp = c;
 		}
 	}
 
+	bump_checkpoint_restore(&self->bump, ckp->bump);
+
 	for(array_count_t j = array_count(self->logs) - 1; j > i; --j)
-		mm_free(array_get_at(self->logs, j).c);
+		mm_checkpoint_free(array_get_at(self->logs, j).c);
 
 	array_count(self->logs) = i + 1;
 	return array_get_at(self->logs, i).ref_i;
@@ -227,9 +789,88 @@ array_count_t model_allocator_fossil_lp_collect(struct mm_state *self, array_cou
 		array_get_at(self->logs, j).ref_i -= ref_i;
 	}
 
+	// the oldest retained checkpoint can't rely on the discarded ones anymore
+	struct mm_checkpoint *oldest = array_get_at(self->logs, log_i).c;
+	if(log_i)
+		oldest->bump = bump_checkpoint_rebase(&self->bump, oldest->bump);
+
 	while(j--)
-		mm_free(array_get_at(self->logs, j).c);
+		mm_checkpoint_free(array_get_at(self->logs, j).c);
 
 	array_truncate_first(self->logs, log_i);
+	mm_buddies_reclaim(self);
 	return ref_i;
 }
+
+/// The alignment of the checkpoints moved to the paging file
+#define mm_paged_align(size) (((size) + 15U) & ~(size_t)15U)
+
+/**
+ * @brief Move the buddy systems and the checkpoints of an LP to the thread paging file
+ * @param self the memory context of the LP
+ * @return the count of bytes moved, 0 if there was nothing to move
+ *
+ * The buddy systems keep their addresses, but the memory backing their buffers is given back to the OS. The
+ * checkpoints are moved as they are, so that the logs keep pointing to valid, albeit file backed, checkpoints.
+ */
+size_t model_allocator_lp_page_out(struct mm_state *self)
+{
+	size_t size = array_count(self->buddies) * (mm_paged_align(sizeof(struct buddy_state)) + (1U << B_TOTAL_EXP));
+	for(array_count_t i = 0; i < array_count(self->logs); ++i)
+		size += mm_paged_align(mm_checkpoint_size(array_get_at(self->logs, i).c));
+
+	if(!size)
+		return 0;
+
+	unsigned char *ptr = paging_extent_alloc(size);
+	self->paged = ptr;
+	self->paged_size = size;
+
+	for(array_count_t i = 0; i < array_count(self->buddies); ++i) {
+		struct buddy_state *b = array_get_at(self->buddies, i);
+		memcpy(ptr, b, sizeof(*b));
+		ptr += mm_paged_align(sizeof(*b));
+		memcpy(ptr, b->base_mem, 1U << B_TOTAL_EXP);
+		mem_region_discard(b->base_mem, 1U << B_TOTAL_EXP);
+		ptr += 1U << B_TOTAL_EXP;
+	}
+
+	for(array_count_t i = 0; i < array_count(self->logs); ++i) {
+		struct mm_checkpoint *c = array_get_at(self->logs, i).c;
+		size_t s = mm_checkpoint_size(c);
+		memcpy(ptr, c, s);
+		mm_free(c);
+		array_get_at(self->logs, i).c = (struct mm_checkpoint *)ptr;
+		ptr += mm_paged_align(s);
+	}
+
+	return size;
+}
+
+/**
+ * @brief Move back the buddy systems and the checkpoints of an LP from the thread paging file
+ * @param self the memory context of the LP, which has been paged out by model_allocator_lp_page_out()
+ */
+void model_allocator_lp_page_in(struct mm_state *self)
+{
+	const unsigned char *ptr = self->paged;
+
+	for(array_count_t i = 0; i < array_count(self->buddies); ++i) {
+		struct buddy_state *b = array_get_at(self->buddies, i);
+		memcpy(b, ptr, sizeof(*b));
+		ptr += mm_paged_align(sizeof(*b));
+		memcpy(b->base_mem, ptr, 1U << B_TOTAL_EXP);
+		ptr += 1U << B_TOTAL_EXP;
+	}
+
+	for(array_count_t i = 0; i < array_count(self->logs); ++i) {
+		size_t s = mm_checkpoint_size(array_get_at(self->logs, i).c);
+		struct mm_checkpoint *c = mm_alloc(s);
+		memcpy(c, ptr, s);
+		array_get_at(self->logs, i).c = c;
+		ptr += mm_paged_align(s);
+	}
+
+	paging_extent_free(self->paged, self->paged_size);
+	self->paged = NULL;
+}
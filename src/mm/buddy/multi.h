@@ -9,9 +9,11 @@
 #pragma once
 
 #include <datatypes/array.h>
+#include <mm/bump.h>
 
 #include <assert.h>
 #include <stdalign.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -19,7 +21,13 @@
 struct mm_checkpoint {
 	/// The total count of allocated bytes at the moment of the checkpoint
 	uint_fast32_t ckpt_size;
-	/// The sequence of checkpoints of the allocated buddy systems (see @a buddy_checkpoint)
+	/// The checkpoint of the append-only arena, NULL if the arena has never been used
+	struct bump_checkpoint *bump;
+	/// The allocation bitmap of the compact chunk at the moment of the checkpoint
+	uint64_t c_used;
+	/// The bitmap of the granules starting an allocation in the compact chunk at the moment of the checkpoint
+	uint64_t c_starts;
+	/// The allocated granules of the compact chunk, followed by the sequence of checkpoints of the allocated buddy systems (see @a buddy_checkpoint)
 	unsigned char chkps[];
 };
 
@@ -39,5 +47,19 @@ struct mm_state {
 	dyn_array(struct mm_log) logs;
 	/// The total count of allocated bytes
 	uint_fast32_t full_ckpt_size;
+	/// The append-only arena
+	struct bump_arena bump;
+	/// The chunk of a thread compact slab which hosts the small allocations of the LP, if any
+	unsigned char *c_chunk;
+	/// The allocation bitmap of the granules of the compact chunk
+	uint64_t c_used;
+	/// The bitmap of the granules of the compact chunk which start an allocation
+	uint64_t c_starts;
+	/// Set if the LP outgrew its compact chunk, so that its new allocations are served by the buddy systems
+	bool c_promoted;
+	/// The image of the buddy systems and checkpoints in the thread paging file, NULL if the LP is resident
+	void *paged;
+	/// The size in bytes of @a paged
+	size_t paged_size;
 };
 
@@ -0,0 +1,267 @@
+/**
+ * @file mm/bump.c
+ *
+ * @brief Append-only memory arena for the LPs
+ *
+ * The arena serves memory by bumping a pointer and never frees it, except when a rollback truncates it. Each byte is
+ * identified by a position, which orders the bytes in allocation order. A checkpoint holds the end of the arena and
+ * the original contents of the bytes modified since the previous checkpoint, which rs_bump_touch() saves in undo
+ * records: for append-only usage a checkpoint holds no bytes at all, and a rollback only has to move the end of the
+ * arena back.
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <mm/bump.h>
+
+#include <core/core.h>
+#include <lp/lp.h>
+
+#include <errno.h>
+
+/// The exponent of the size of the first chunk of a bump arena
+#define BUMP_CHUNK_MIN_EXP 10U
+/// The exponent of the size which the chunks stop growing at, bigger requests get a chunk of their own size
+#define BUMP_CHUNK_MAX_EXP 16U
+/// The alignment of the memory served by a bump arena
+#define BUMP_ALIGN 16U
+/// The alignment of the undo records of a bump arena
+#define BUMP_UNDO_ALIGN 8U
+
+/// Compute the position of a byte from the index of its chunk and its offset in the chunk
+#define bump_pos(chunk_i, off) (((uint64_t)(chunk_i) << 32U) | (uint32_t)(off))
+/// Get the index of the chunk of a position
+#define bump_pos_chunk(pos) ((array_count_t)((pos) >> 32U))
+/// Get the offset in its chunk of a position
+#define bump_pos_off(pos) ((uint32_t)(pos))
+
+/// The trailer of an undo record, which follows the saved bytes so that the records can be walked backwards
+struct bump_undo {
+	/// The position of the first saved byte
+	uint64_t pos;
+	/// The count of saved bytes
+	uint64_t size;
+};
+
+/// Compute the space taken by the saved bytes of an undo record
+#define bump_undo_data_size(size) (((size) + BUMP_UNDO_ALIGN - 1) & ~(uint64_t)(BUMP_UNDO_ALIGN - 1))
+
+/**
+ * @brief Get the position of the end of a bump arena
+ * @param self the bump arena
+ * @return the position which the next served byte would have, if it fit in the last chunk
+ */
+static inline uint64_t bump_mark(const struct bump_arena *self)
+{
+	if(array_count(self->chunks) == 0)
+		return 0;
+
+	array_count_t i = array_count(self->chunks) - 1;
+	return bump_pos(i, array_get_at(self->chunks, i).used);
+}
+
+/**
+ * @brief Write back the original contents saved in a sequence of undo records
+ * @param self the bump arena, already truncated at @p mark
+ * @param undo the undo records
+ * @param size the size in bytes of @p undo
+ * @param mark the end of the arena
+ *
+ * The records are applied from the most recent one, so that the oldest saved contents of each byte win. The saved
+ * bytes past @p mark belong to memory which has been dropped, hence they are skipped.
+ */
+static void bump_undo_apply(struct bump_arena *self, const unsigned char *undo, uint64_t size, uint64_t mark)
+{
+	while(size) {
+		struct bump_undo u;
+		size -= sizeof(u);
+		memcpy(&u, undo + size, sizeof(u));
+		size -= bump_undo_data_size(u.size);
+		if(u.pos >= mark)
+			continue;
+
+		const struct bump_chunk *k = &array_get_at(self->chunks, bump_pos_chunk(u.pos));
+		uint32_t off = bump_pos_off(u.pos);
+		memcpy(k->mem + off, undo + size, min(u.size, k->used - off));
+	}
+}
+
+void bump_arena_init(struct bump_arena *self)
+{
+	// the chunks array is initialized on the first allocation, so that LPs which don't use the arena pay nothing
+	array_items(self->chunks) = NULL;
+	array_count(self->chunks) = 0;
+	array_capacity(self->chunks) = 0;
+	self->last = NULL;
+	array_items(self->undo) = NULL;
+	array_count(self->undo) = 0;
+	array_capacity(self->undo) = 0;
+}
+
+void bump_arena_fini(struct bump_arena *self)
+{
+	if(array_items(self->undo) != NULL)
+		array_fini(self->undo);
+
+	if(array_items(self->chunks) == NULL)
+		return;
+
+	while(!array_is_empty(self->chunks))
+		mm_free(array_pop(self->chunks).mem);
+	array_fini(self->chunks);
+}
+
+/**
+ * @brief Take a checkpoint of a bump arena
+ * @param self the bump arena
+ * @return the new checkpoint, NULL if the arena is empty and has never been checkpointed
+ */
+struct bump_checkpoint *bump_checkpoint_take(struct bump_arena *self)
+{
+	uint64_t mark = bump_mark(self);
+	if(likely(self->last == NULL && mark == 0))
+		return NULL;
+
+	size_t size = array_count(self->undo);
+	struct bump_checkpoint *ret = mm_alloc(offsetof(struct bump_checkpoint, undo) + size);
+	ret->prev = self->last;
+	ret->mark = mark;
+	ret->undo_size = size;
+	if(size)
+		memcpy(ret->undo, array_items(self->undo), size);
+
+	self->last = ret;
+	array_count(self->undo) = 0;
+	return ret;
+}
+
+/**
+ * @brief Restore a bump arena from a checkpoint
+ * @param self the bump arena
+ * @param ckp the checkpoint to restore, possibly NULL
+ *
+ * The arena is truncated at the end it had in @p ckp; then the bytes modified after @p ckp was taken are written back
+ * from the undo records of the more recent checkpoints. The more recent checkpoints must still be available, the
+ * caller frees them afterwards.
+ */
+void bump_checkpoint_restore(struct bump_arena *self, struct bump_checkpoint *ckp)
+{
+	uint64_t mark = ckp == NULL ? 0 : ckp->mark;
+	array_count_t n = ckp == NULL ? 0 : bump_pos_chunk(mark) + 1;
+	while(array_count(self->chunks) > n)
+		mm_free(array_pop(self->chunks).mem);
+	if(n)
+		array_get_at(self->chunks, n - 1).used = bump_pos_off(mark);
+
+	bump_undo_apply(self, array_items(self->undo), array_count(self->undo), mark);
+	array_count(self->undo) = 0;
+	for(const struct bump_checkpoint *c = self->last; c != ckp; c = c->prev)
+		bump_undo_apply(self, c->undo, c->undo_size, mark);
+
+	self->last = ckp;
+}
+
+/**
+ * @brief Detach a checkpoint of a bump arena from the ones preceding it, so that they can be freed
+ * @param self the bump arena
+ * @param ckp the checkpoint, possibly NULL
+ * @return the checkpoint which replaces @p ckp
+ *
+ * This is carried out during fossil collection. The undo records of @p ckp are only needed to restore the preceding
+ * checkpoints, so they are dropped as well.
+ */
+struct bump_checkpoint *bump_checkpoint_rebase(struct bump_arena *self, struct bump_checkpoint *ckp)
+{
+	if(ckp == NULL)
+		return NULL;
+
+	ckp->prev = NULL;
+	if(ckp->undo_size == 0)
+		return ckp;
+
+	struct bump_checkpoint **link = &self->last;
+	while(*link != ckp)
+		link = &(*link)->prev;
+
+	ckp = mm_realloc(ckp, offsetof(struct bump_checkpoint, undo));
+	ckp->undo_size = 0;
+	*link = ckp;
+	return ckp;
+}
+
+/**
+ * @brief Allocate memory from the append-only arena of the current LP
+ * @param req_size the size in bytes of the requested memory
+ * @return a pointer to the allocated memory, NULL if @p req_size is zero or too big
+ *
+ * The memory is only given back when a rollback undoes its allocation, or when the LP is finalized.
+ */
+void *rs_bump_alloc(size_t req_size)
+{
+	if(unlikely(!req_size))
+		return NULL;
+
+	if(unlikely(req_size > UINT32_MAX - BUMP_ALIGN)) {
+		errno = ENOMEM;
+		logger(LOG_WARN, "LP %p requested a memory block bigger than %u!", current_lp, UINT32_MAX - BUMP_ALIGN);
+		return NULL;
+	}
+
+	struct bump_arena *self = &lp_cold(current_lp)->mm_state.bump;
+	uint32_t size = (req_size + BUMP_ALIGN - 1) & ~(BUMP_ALIGN - 1);
+
+	if(likely(array_count(self->chunks))) {
+		struct bump_chunk *k = &array_peek(self->chunks);
+		if(likely(k->size - k->used >= size)) {
+			void *ret = k->mem + k->used;
+			k->used += size;
+			return ret;
+		}
+	} else if(array_items(self->chunks) == NULL) {
+		array_init(self->chunks);
+	}
+
+	uint32_t c_size = 1U << min(BUMP_CHUNK_MIN_EXP + array_count(self->chunks), BUMP_CHUNK_MAX_EXP);
+	struct bump_chunk k = {.mem = mm_alloc(max(c_size, size)), .size = max(c_size, size), .used = size};
+	array_push(self->chunks, k);
+	return k.mem;
+}
+
+/**
+ * @brief Declare that some memory served by the append-only arena of the current LP is going to be modified
+ * @param ptr a pointer to the memory
+ * @param size the size in bytes of the memory
+ *
+ * This must be called, before the modification, for each modification of memory allocated before the last
+ * checkpoint. Writes to memory allocated afterwards needn't be declared.
+ */
+void rs_bump_touch(const void *ptr, size_t size)
+{
+	struct bump_arena *self = &lp_cold(current_lp)->mm_state.bump;
+	// a rollback drops the memory allocated after the last checkpoint, so its contents needn't be saved
+	if(self->last == NULL || !size)
+		return;
+
+	uint64_t mark = self->last->mark;
+	array_count_t i = min(array_count(self->chunks), bump_pos_chunk(mark) + 1);
+	while(i--) {
+		const struct bump_chunk *k = &array_get_at(self->chunks, i);
+		uintptr_t off = (uintptr_t)ptr - (uintptr_t)k->mem;
+		if(off >= k->used)
+			continue;
+
+		uint32_t end = i == bump_pos_chunk(mark) ? bump_pos_off(mark) : k->used;
+		if(off >= end)
+			return;
+
+		struct bump_undo u = {.pos = bump_pos(i, off), .size = min(size, end - off)};
+		if(array_items(self->undo) == NULL)
+			array_init(self->undo);
+		array_reserve(self->undo, bump_undo_data_size(u.size) + sizeof(u));
+		unsigned char *rec = array_items(self->undo) + array_count(self->undo);
+		memcpy(rec, k->mem + off, u.size);
+		memcpy(rec + bump_undo_data_size(u.size), &u, sizeof(u));
+		array_count(self->undo) += bump_undo_data_size(u.size) + sizeof(u);
+		return;
+	}
+}
@@ -0,0 +1,51 @@
+/**
+ * @file mm/bump.h
+ *
+ * @brief Append-only memory arena for the LPs
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#pragma once
+
+#include <datatypes/array.h>
+
+#include <stdint.h>
+
+/// A chunk of memory of a bump arena
+struct bump_chunk {
+	/// The memory of the chunk
+	unsigned char *mem;
+	/// The size in bytes of @a mem
+	uint32_t size;
+	/// The count of bytes of @a mem already served
+	uint32_t used;
+};
+
+/// The checkpoint of a bump arena, holding the original contents of the bytes modified since the previous checkpoint
+struct bump_checkpoint {
+	/// The previous checkpoint
+	struct bump_checkpoint *prev;
+	/// The position of the end of the arena at the moment of the checkpoint
+	uint64_t mark;
+	/// The size in bytes of @a undo
+	uint64_t undo_size;
+	/// The undo records of the bytes modified between the previous checkpoint and this one
+	unsigned char undo[];
+};
+
+/// An append-only memory arena, owned by a single LP
+struct bump_arena {
+	/// The chunks of the arena, in allocation order
+	dyn_array(struct bump_chunk) chunks;
+	/// The most recent checkpoint of the arena
+	struct bump_checkpoint *last;
+	/// The undo records of the bytes modified since the last checkpoint
+	dyn_array(unsigned char) undo;
+};
+
+extern void bump_arena_init(struct bump_arena *self);
+extern void bump_arena_fini(struct bump_arena *self);
+extern struct bump_checkpoint *bump_checkpoint_take(struct bump_arena *self);
+extern void bump_checkpoint_restore(struct bump_arena *self, struct bump_checkpoint *ckp);
+extern struct bump_checkpoint *bump_checkpoint_rebase(struct bump_arena *self, struct bump_checkpoint *ckp);
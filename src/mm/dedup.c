@@ -0,0 +1,138 @@
+/**
+ * @file mm/dedup.c
+ *
+ * @brief Content-addressed store of checkpointed memory blocks
+ *
+ * Each thread keeps a hash table of the memory blocks saved by the checkpoints of its LPs. Checkpoints reference the
+ * blocks instead of copying them, so that identical content, either of the same LP across consecutive checkpoints or
+ * of different LPs, is stored only once.
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <mm/dedup.h>
+
+#include <core/core.h>
+#include <log/stats.h>
+#include <mm/mm.h>
+
+#include <string.h>
+
+/// The initial count of buckets of a store
+#define DEDUP_INIT_BUCKETS 256U
+
+/// The store of the blocks saved by the checkpoints of the LPs bound to the current thread
+static __thread struct {
+	/// The buckets of the hash table
+	struct dedup_block **buckets;
+	/// The count of buckets, a power of 2
+	size_t n_buckets;
+	/// The count of stored blocks
+	size_t count;
+} store;
+
+/**
+ * @brief Compute the hash of a memory block
+ * @param data the content of the block
+ * @param len the size in bytes of the block
+ * @return the 64-bit hash of the block
+ */
+static uint64_t dedup_hash(const unsigned char *data, uint32_t len)
+{
+	uint64_t h = 0x9E3779B97F4A7C15ULL ^ len;
+	uint32_t i = 0;
+	for(; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+		uint64_t w;
+		memcpy(&w, data + i, sizeof(w));
+		h = (h ^ w) * 0xBF58476D1CE4E5B9ULL;
+		h ^= h >> 31;
+	}
+	for(; i < len; ++i)
+		h = (h ^ data[i]) * 0x94D049BB133111EBULL;
+	return h ^ (h >> 29);
+}
+
+/**
+ * @brief Double the count of buckets of the store
+ */
+static void dedup_store_grow(void)
+{
+	size_t n = store.n_buckets ? store.n_buckets * 2 : DEDUP_INIT_BUCKETS;
+	struct dedup_block **buckets = mm_alloc(n * sizeof(*buckets));
+	memset(buckets, 0, n * sizeof(*buckets));
+
+	for(size_t i = 0; i < store.n_buckets; ++i) {
+		struct dedup_block *b = store.buckets[i];
+		while(b != NULL) {
+			struct dedup_block *next = b->next;
+			b->next = buckets[b->hash & (n - 1)];
+			buckets[b->hash & (n - 1)] = b;
+			b = next;
+		}
+	}
+
+	mm_free(store.buckets);
+	store.buckets = buckets;
+	store.n_buckets = n;
+}
+
+/**
+ * @brief Get a reference to the stored block with a given content, storing it if needed
+ * @param data the content of the block
+ * @param len the size in bytes of the block
+ * @return the stored block, whose reference is owned by the caller
+ */
+const struct dedup_block *dedup_block_get(const unsigned char *data, uint32_t len)
+{
+	uint64_t h = dedup_hash(data, len);
+	stats_take(STATS_CKPT_DEDUP_LOOKUPS, 1);
+
+	if(likely(store.n_buckets)) {
+		for(struct dedup_block *b = store.buckets[h & (store.n_buckets - 1)]; b != NULL; b = b->next) {
+			if(b->hash == h && b->len == len && !memcmp(b->data, data, len)) {
+				++b->refs;
+				stats_take(STATS_CKPT_DEDUP_HITS, 1);
+				stats_take(STATS_CKPT_DEDUP_SAVED, len);
+				return b;
+			}
+		}
+	}
+
+	if(unlikely(store.count >= store.n_buckets))
+		dedup_store_grow();
+
+	struct dedup_block *b = mm_alloc(offsetof(struct dedup_block, data) + len);
+	b->hash = h;
+	b->refs = 1;
+	b->len = len;
+	memcpy(b->data, data, len);
+	b->next = store.buckets[h & (store.n_buckets - 1)];
+	store.buckets[h & (store.n_buckets - 1)] = b;
+	++store.count;
+	return b;
+}
+
+/**
+ * @brief Drop a reference to a stored block, releasing it if it was the last one
+ * @param b the stored block
+ *
+ * The store itself is released along with its last block.
+ */
+void dedup_block_put(const struct dedup_block *b)
+{
+	struct dedup_block *m = (struct dedup_block *)b;
+	if(--m->refs)
+		return;
+
+	struct dedup_block **p = &store.buckets[m->hash & (store.n_buckets - 1)];
+	while(*p != m)
+		p = &(*p)->next;
+	*p = m->next;
+	mm_free(m);
+
+	if(likely(--store.count))
+		return;
+
+	mm_free(store.buckets);
+	memset(&store, 0, sizeof(store));
+}
@@ -0,0 +1,29 @@
+/**
+ * @file mm/dedup.h
+ *
+ * @brief Content-addressed store of checkpointed memory blocks
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#pragma once
+
+#include <stdalign.h>
+#include <stdint.h>
+
+/// A block of checkpointed memory, shared by all the checkpoints which saved the same content
+struct dedup_block {
+	/// The next block in the same bucket of the store
+	struct dedup_block *next;
+	/// The hash of the content of this block
+	uint64_t hash;
+	/// The count of checkpoints which reference this block
+	uint32_t refs;
+	/// The size in bytes of the content of this block
+	uint32_t len;
+	/// The content of this block
+	alignas(16) unsigned char data[];
+};
+
+extern const struct dedup_block *dedup_block_get(const unsigned char *data, uint32_t len);
+extern void dedup_block_put(const struct dedup_block *b);
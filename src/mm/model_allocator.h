@@ -11,10 +11,17 @@
 #pragma once
 
 #include <datatypes/array.h>
+#ifdef ROOTSIM_SLAB_ALLOCATOR
+#include <mm/slab/multi.h>
+#else
 #include <mm/buddy/multi.h>
+#endif
 
 extern void model_allocator_lp_init(struct mm_state *self);
 extern void model_allocator_lp_fini(struct mm_state *self);
+extern void model_allocator_thread_drop(void);
+extern size_t model_allocator_lp_page_out(struct mm_state *self);
+extern void model_allocator_lp_page_in(struct mm_state *self);
 extern void model_allocator_checkpoint_take(struct mm_state *self, array_count_t ref_i);
 extern void model_allocator_checkpoint_next_force_full(struct mm_state *self);
 extern array_count_t model_allocator_checkpoint_restore(struct mm_state *self, array_count_t ref_i);
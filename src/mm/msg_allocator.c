@@ -10,34 +10,269 @@
  */
 #include <mm/msg_allocator.h>
 
+#include <arch/mem.h>
 #include <core/core.h>
+#include <core/intrinsics.h>
+#include <core/sync.h>
 #include <datatypes/array.h>
+#include <datatypes/heap.h>
 #include <gvt/gvt.h>
+#include <log/stats.h>
 
-static __thread dyn_array(struct lp_msg *) free_list = {0};
-static __thread dyn_array(struct lp_msg *) at_gvt_list = {0};
+#include <stdalign.h>
+#include <stdatomic.h>
+
+/// The count of messages owned by another thread which are batched before returning them
+#define MSG_MAGAZINE_SIZE 64U
+/// The maximum count of committed messages released by a single call to msg_allocator_at_gvt_collect()
+#define MSG_AT_GVT_BUDGET 256U
+/// Determine an ordering between two messages waiting to be freed at GVT
+#define at_gvt_elem_is_before(a, b) ((a).t < (b).t)
+
+/// The count of pooled messages of the smallest size class which are never trimmed, halved for each larger class
+#define MSG_FREE_LIST_MIN 1024U
+/// The exponent of the size of the chunks in which the message arena grows, which is also the size of the huge pages
+#define MSG_ARENA_CHUNK_EXP 21U
+/// The factor by which the calibration enlarges the pools, relative to the messages needed in the first GVT phase
+#define MSG_POOL_CALIBRATE_FACTOR 4U
+
+/// The size in bytes of the messages of a size class
+#define msg_class_size(c)                                                                                              \
+	(offsetof(struct lp_msg, extra_pl) + ((size_t)MSG_PAYLOAD_BASE_SIZE << (c)) - MSG_PAYLOAD_BASE_SIZE)
+
+/// Check if the pooled messages are carved from the thread message arena instead of being allocated one by one
+#define msg_arena_enabled() (global_config.msg_pool_size || global_config.msg_pool_calibrate)
+
+/// The pool of the freed messages of a size class
+struct msg_pool {
+	/// The freed messages
+	dyn_array(struct lp_msg *) free_list;
+	/// The lowest count of pooled messages since the last GVT, i.e. the messages which weren't needed meanwhile
+	array_count_t low;
+	/// The count of messages carved from the message arena for this pool
+	size_t carved;
+};
+
+/// A region of the thread message arena
+struct msg_region {
+	/// The reserved range, as returned by mem_region_reserve()
+	void *raw;
+	/// The size in bytes of the reserved range
+	size_t size;
+};
+
+/// A batch of freed messages, linked through lp_msg.next, which must be returned to their owner thread
+struct msg_magazine {
+	/// The first message of the batch
+	struct lp_msg *head;
+	/// The last message of the batch
+	struct lp_msg *tail;
+	/// The count of messages in the batch
+	unsigned count;
+};
+
+/// A message waiting for its destination time to be committed
+struct at_gvt_elem {
+	/// The destination time of the message
+	simtime_t t;
+	/// The message to free
+	struct lp_msg *m;
+};
+
+/// The list of messages returned to a thread, implemented as a non-blocking list
+struct msg_return {
+	/// The head of the messages list
+	alignas(CACHE_LINE_SIZE) _Atomic(struct lp_msg *) list;
+};
+
+/// The return lists vector
+static struct msg_return *returns;
+/// The pools of the current thread, indexed by size class
+static __thread struct msg_pool pools[MSG_SIZE_CLASSES];
+/// The messages to free once their destination time is committed, ordered by destination time
+static __thread heap_declare(struct at_gvt_elem) at_gvt_heap;
+/// The latest GVT value, below which the messages in @a at_gvt_heap can be freed
+static __thread simtime_t at_gvt_bound;
+/// The batches of freed messages owned by the other threads, indexed by owner
+static __thread struct msg_magazine *magazines;
+/// The regions of the message arena of the current thread
+static __thread dyn_array(struct msg_region) arena;
+/// If set, the pools of the current thread have already been enlarged by the calibration
+static __thread bool pools_calibrated;
+
+/**
+ * @brief Compute the size class of a message
+ * @param payload_size the size in bytes of the message payload
+ * @return the size class of the message, MSG_SIZE_CLASSES or more if the message is too large to be pooled
+ *
+ * The messages of class i have room for MSG_PAYLOAD_BASE_SIZE << i bytes of payload.
+ */
+static inline unsigned msg_size_class(unsigned payload_size)
+{
+	if(likely(payload_size <= MSG_PAYLOAD_BASE_SIZE))
+		return 0;
+	unsigned r = (payload_size - 1) / MSG_PAYLOAD_BASE_SIZE;
+	return sizeof(r) * CHAR_BIT - intrinsics_clz(r);
+}
+
+/**
+ * @brief Carve some messages out of a new region of the thread message arena
+ * @param c the size class of the messages
+ * @param cnt the minimum count of messages to carve
+ *
+ * The region is rounded up to a whole count of chunks, backed by huge pages where available, and pre-faulted, so that
+ * the pooled messages don't trigger page faults once handed out.
+ */
+static void msg_arena_carve(unsigned c, size_t cnt)
+{
+	size_t m_size = (msg_class_size(c) + alignof(struct lp_msg) - 1) & ~(alignof(struct lp_msg) - 1);
+	size_t chunk = (size_t)1U << MSG_ARENA_CHUNK_EXP;
+	size_t size = (max(cnt * m_size, (size_t)1U) + chunk - 1) & ~(chunk - 1);
+
+	struct msg_region r = {.size = size + chunk};
+	r.raw = mem_region_reserve(r.size);
+	if(unlikely(r.raw == NULL)) {
+		logger(LOG_FATAL, "Unable to reserve the address range for the messages!");
+		abort();
+	}
+	uintptr_t b = ((uintptr_t)r.raw + chunk - 1) & ~(chunk - 1);
+	mem_region_huge_advise((void *)b, size);
+	if(unlikely(mem_region_commit((void *)b, size))) {
+		logger(LOG_FATAL, "Out of memory!");
+		abort();
+	}
+	mem_region_prefault((void *)b, size);
+	array_push(arena, r);
+
+	struct msg_pool *pool = &pools[c];
+	cnt = size / m_size;
+	pool->carved += cnt;
+	array_reserve(pool->free_list, cnt);
+	while(cnt--)
+		array_push(pool->free_list, (struct lp_msg *)(b + cnt * m_size));
+}
+
+/**
+ * @brief Enlarge the pools according to the messages needed so far
+ *
+ * This is called at the end of the first GVT phase, when the message arena is in use: the messages carved so far are
+ * a good estimate of the messages in flight for each size class.
+ */
+static void msg_pools_calibrate(void)
+{
+	for(unsigned i = 0; i < MSG_SIZE_CLASSES; ++i)
+		if(pools[i].carved)
+			msg_arena_carve(i, pools[i].carved * (MSG_POOL_CALIBRATE_FACTOR - 1));
+	pools_calibrated = true;
+}
+
+/**
+ * @brief Initialize the message allocator at the node level
+ */
+void msg_allocator_global_init(void)
+{
+	returns = mm_aligned_alloc(CACHE_LINE_SIZE, global_config.n_threads * sizeof(*returns));
+}
+
+/**
+ * @brief Finalize the message allocator at the node level
+ */
+void msg_allocator_global_fini(void)
+{
+	mm_aligned_free(returns);
+}
 
 /**
  * @brief Initialize the message allocator thread-local data structures
  */
 void msg_allocator_init(void)
 {
-	array_init(at_gvt_list);
-	array_init(free_list);
+	heap_init(at_gvt_heap);
+	at_gvt_bound = 0;
+	for(unsigned i = 0; i < MSG_SIZE_CLASSES; ++i) {
+		array_init(pools[i].free_list);
+		pools[i].low = 0;
+		pools[i].carved = 0;
+	}
+	magazines = mm_alloc(global_config.n_threads * sizeof(*magazines));
+	memset(magazines, 0, global_config.n_threads * sizeof(*magazines));
+	atomic_store_explicit(&returns[rid].list, NULL, memory_order_relaxed);
+
+	array_init(arena);
+	pools_calibrated = false;
+	if(global_config.msg_pool_size)
+		msg_arena_carve(0, global_config.msg_pool_size);
+}
+
+/**
+ * @brief Release a list of messages linked through lp_msg.next
+ * @param msg the first message of the list
+ */
+static void msg_list_free(struct lp_msg *msg)
+{
+	while(msg != NULL) {
+		struct lp_msg *next = msg->next;
+		mm_free(msg);
+		msg = next;
+	}
 }
 
 /**
  * @brief Finalize the message allocator thread-local data structures
+ *
+ * With a fast teardown, the pooled messages are left to the OS. Otherwise, the batched messages of other threads are
+ * released directly, since their owners may have already finalized their allocator. If the message arena is in use,
+ * the pooled messages are instead released in bulk along with the arena, and the messages of other threads are left to
+ * their owner arena.
  */
 void msg_allocator_fini(void)
 {
-	while(!array_is_empty(free_list))
-		mm_free(array_pop(free_list));
-	array_fini(free_list);
+	if(global_config.fast_teardown)
+		return;
+
+	bool a = msg_arena_enabled();
+	for(unsigned i = 0; i < MSG_SIZE_CLASSES; ++i) {
+		while(!a && !array_is_empty(pools[i].free_list))
+			mm_free(array_pop(pools[i].free_list));
+		array_fini(pools[i].free_list);
+	}
+
+	for(array_count_t i = 0; i < heap_count(at_gvt_heap); ++i) {
+		struct lp_msg *msg = heap_items(at_gvt_heap)[i].m;
+		if(!a || msg_size_class(msg->pl_size) >= MSG_SIZE_CLASSES)
+			mm_free(msg);
+	}
+	heap_fini(at_gvt_heap);
 
-	while(!array_is_empty(at_gvt_list))
-		mm_free(array_pop(at_gvt_list));
-	array_fini(at_gvt_list);
+	for(rid_t i = 0; i < global_config.n_threads; ++i)
+		if(!a)
+			msg_list_free(magazines[i].head);
+	mm_free(magazines);
+
+	struct lp_msg *returned = atomic_exchange_explicit(&returns[rid].list, NULL, memory_order_acquire);
+	if(!a)
+		msg_list_free(returned);
+
+	while(!array_is_empty(arena)) {
+		struct msg_region r = array_pop(arena);
+		mem_region_release(r.raw, r.size);
+	}
+	array_fini(arena);
+}
+
+/**
+ * @brief Move the messages returned by the other threads in the pools of the current thread
+ */
+static void msg_allocator_reclaim(void)
+{
+	struct lp_msg *msg = atomic_exchange_explicit(&returns[rid].list, NULL, memory_order_acquire);
+	uint_fast64_t n = 0;
+	while(msg != NULL) {
+		array_push(pools[msg_size_class(msg->pl_size)].free_list, msg);
+		msg = msg->next;
+		++n;
+	}
+	stats_take(STATS_MSG_RECLAIMED, n);
 }
 
 /**
@@ -45,33 +280,86 @@ void msg_allocator_fini(void)
  * @param payload_size the size in bytes of the requested message payload
  * @return a new message with at least the requested amount of payload space
  *
- * Since this module relies on the member lp_msg.pl_size (see @a msg_allocator_free()), it has writing responsibility
- * on it.
+ * Since this module relies on the members lp_msg.pl_size and lp_msg.owner (see @a msg_allocator_free()), it has
+ * writing responsibility on them.
  */
 struct lp_msg *msg_allocator_alloc(unsigned payload_size)
 {
 	struct lp_msg *ret;
-	if(unlikely(payload_size > MSG_PAYLOAD_BASE_SIZE)) {
+	unsigned c = msg_size_class(payload_size);
+	if(unlikely(c >= MSG_SIZE_CLASSES)) {
+		stats_take(STATS_MSG_UNPOOLED, 1);
 		ret = mm_alloc(offsetof(struct lp_msg, extra_pl) + (payload_size - MSG_PAYLOAD_BASE_SIZE));
-	} else if(unlikely(array_is_empty(free_list))) {
-		ret = mm_alloc(sizeof(struct lp_msg));
 	} else {
-		ret = array_pop(free_list);
+		struct msg_pool *pool = &pools[c];
+		if(unlikely(array_is_empty(pool->free_list)))
+			msg_allocator_reclaim();
+
+		if(likely(!array_is_empty(pool->free_list))) {
+			stats_take(STATS_MSG_POOL_HIT + c, 1);
+			ret = array_pop(pool->free_list);
+		} else if(msg_arena_enabled()) {
+			stats_take(STATS_MSG_POOL_MISS + c, 1);
+			msg_arena_carve(c, 0);
+			ret = array_pop(pool->free_list);
+		} else {
+			stats_take(STATS_MSG_POOL_MISS + c, 1);
+			ret = mm_alloc(msg_class_size(c));
+		}
+
+		if(unlikely(array_count(pool->free_list) < pool->low))
+			pool->low = array_count(pool->free_list);
 	}
+	ret->owner = rid;
 	ret->pl_size = payload_size;
 	return ret;
 }
 
+/**
+ * @brief Return a batch of freed messages to their owner thread
+ * @param owner the identifier of the owner thread
+ */
+static void msg_magazine_flush(rid_t owner)
+{
+	struct msg_magazine *mag = &magazines[owner];
+	_Atomic(struct lp_msg *) *list_p = &returns[owner].list;
+	mag->tail->next = atomic_load_explicit(list_p, memory_order_relaxed);
+	while(unlikely(!atomic_compare_exchange_weak_explicit(list_p, &mag->tail->next, mag->head,
+	    memory_order_release, memory_order_relaxed)))
+		spin_pause();
+
+	stats_take(STATS_MSG_RETURNED, mag->count);
+	mag->head = NULL;
+	mag->count = 0;
+}
+
 /**
  * @brief Free a message
  * @param msg a pointer to the message to release
+ *
+ * Messages owned by other threads are batched and then returned to their owner, so that the pools of the receiving
+ * threads don't grow at the expense of the sending ones.
  */
 void msg_allocator_free(struct lp_msg *msg)
 {
-	if(likely(msg->pl_size <= MSG_PAYLOAD_BASE_SIZE))
-		array_push(free_list, msg);
-	else
+	unsigned c = msg_size_class(msg->pl_size);
+	if(unlikely(c >= MSG_SIZE_CLASSES)) {
 		mm_free(msg);
+		return;
+	}
+
+	if(likely(msg->owner == rid)) {
+		array_push(pools[c].free_list, msg);
+		return;
+	}
+
+	struct msg_magazine *mag = &magazines[msg->owner];
+	if(mag->head == NULL)
+		mag->tail = msg;
+	msg->next = mag->head;
+	mag->head = msg;
+	if(unlikely(++mag->count >= MSG_MAGAZINE_SIZE))
+		msg_magazine_flush(msg->owner);
 }
 
 /**
@@ -80,21 +368,53 @@ void msg_allocator_free(struct lp_msg *msg)
  */
 void msg_allocator_free_at_gvt(struct lp_msg *msg)
 {
-	array_push(at_gvt_list, msg);
+	struct at_gvt_elem e = {.t = msg->dest_t, .m = msg};
+	heap_insert(at_gvt_heap, at_gvt_elem_is_before, e);
 }
 
 /**
- * @brief Free the committed messages after a new GVT has been computed
+ * @brief Free some of the messages whose destination time has been committed
+ *
+ * At most MSG_AT_GVT_BUDGET messages are released, so that the work following a GVT computation is spread over the
+ * next iterations of the processing loop. Only the freeable messages are visited.
+ */
+void msg_allocator_at_gvt_collect(void)
+{
+	unsigned budget = MSG_AT_GVT_BUDGET;
+	while(!heap_is_empty(at_gvt_heap) && heap_min(at_gvt_heap).t < at_gvt_bound && budget--)
+		msg_allocator_free(heap_extract(at_gvt_heap, at_gvt_elem_is_before).m);
+}
+
+/**
+ * @brief Start freeing the committed messages after a new GVT has been computed
  * @param current_gvt the latest value of the GVT
+ *
+ * The partial batches of messages owned by other threads are returned as well, and the pooled messages which weren't
+ * needed since the previous GVT are released.
  */
 void msg_allocator_on_gvt(simtime_t current_gvt)
 {
-	for(array_count_t i = array_count(at_gvt_list); i-- > 0;) {
-		struct lp_msg *msg = array_get_at(at_gvt_list, i);
-		if(msg->dest_t < current_gvt) {
-			msg_allocator_free(msg);
-			array_lazy_remove_at(at_gvt_list, i);
+	at_gvt_bound = current_gvt;
+	msg_allocator_at_gvt_collect();
+
+	for(rid_t i = 0; i < global_config.n_threads; ++i)
+		if(magazines[i].head != NULL)
+			msg_magazine_flush(i);
+
+	if(unlikely(global_config.msg_pool_calibrate && !pools_calibrated))
+		msg_pools_calibrate();
+
+	for(unsigned i = 0; i < MSG_SIZE_CLASSES; ++i) {
+		struct msg_pool *pool = &pools[i];
+		if(!msg_arena_enabled() && pool->low > MSG_FREE_LIST_MIN >> i) {
+			array_count_t trim = pool->low - (MSG_FREE_LIST_MIN >> i);
+			stats_take(STATS_MSG_POOL_TRIMMED, trim);
+			while(trim--)
+				mm_free(array_pop(pool->free_list));
+			array_shrink(pool->free_list);
 		}
+		pool->low = array_count(pool->free_list);
+		stats_take(STATS_MSG_POOL_SIZE, array_count(pool->free_list));
 	}
 }
 
@@ -10,10 +10,13 @@
  */
 #pragma once
 
+#include <log/log.h>
 #include <lp/msg.h>
 
 #include <memory.h>
 
+extern void msg_allocator_global_init(void);
+extern void msg_allocator_global_fini(void);
 extern void msg_allocator_init(void);
 extern void msg_allocator_fini(void);
 
@@ -21,10 +24,18 @@ extern struct lp_msg *msg_allocator_alloc(unsigned payload_size);
 extern void msg_allocator_free(struct lp_msg *msg);
 extern void msg_allocator_free_at_gvt(struct lp_msg *msg);
 extern void msg_allocator_on_gvt(simtime_t current_gvt);
+extern void msg_allocator_at_gvt_collect(void);
 
 static inline struct lp_msg *msg_allocator_pack(lp_id_t receiver, simtime_t timestamp, unsigned event_type,
     const void *payload, unsigned payload_size)
 {
+#ifdef ROOTSIM_COMPACT_MSG
+	if(unlikely(event_type > UINT16_MAX || payload_size > UINT16_MAX)) {
+		logger(LOG_FATAL, "Event type %u or payload size %u too large for the compact messages!", event_type,
+		    payload_size);
+		abort();
+	}
+#endif
 	struct lp_msg *msg = msg_allocator_alloc(payload_size);
 
 	msg->dest = receiver;
@@ -0,0 +1,168 @@
+/**
+ * @file mm/paging.c
+ *
+ * @brief Paging of the memory of the idle LPs to a memory-mapped file
+ *
+ * Each thread maps a sparse file, in which the memory of its LPs which have been idle for a while is moved. Unlike
+ * the anonymous memory of the resident LPs, the pages of the file can be written back and dropped by the OS whenever
+ * the physical memory runs short. An LP is paged back in as soon as one of its messages is extracted.
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <mm/paging.h>
+
+#include <gvt/fossil.h>
+#include <log/stats.h>
+
+/// The exponent of the size of the paging file of each thread
+#ifndef PAGING_FILE_EXP
+#define PAGING_FILE_EXP (sizeof(void *) > 4 ? 36U : 28U)
+#endif
+/// The granularity in bytes of the extents of the paging file, which is a multiple of the page size
+#define PAGING_EXTENT_ALIGN 4096U
+
+/// A free extent of the paging file
+struct paging_extent {
+	/// The offset of the extent in the file
+	size_t off;
+	/// The size in bytes of the extent
+	size_t size;
+};
+
+/// The paging file of the current thread
+static __thread struct {
+	/// The mapping of the file, NULL if no LP has been paged out yet
+	unsigned char *base;
+	/// The offset of the never used part of the file
+	size_t top;
+	/// The released extents below @a top
+	dyn_array(struct paging_extent) free;
+} p_file;
+
+/**
+ * @brief Allocate an extent of the thread paging file
+ * @param size the size in bytes of the extent
+ * @return a pointer to the mapped extent
+ */
+void *paging_extent_alloc(size_t size)
+{
+	size = (size + PAGING_EXTENT_ALIGN - 1) & ~((size_t)PAGING_EXTENT_ALIGN - 1);
+
+	if(unlikely(p_file.base == NULL)) {
+		p_file.base = mem_file_map(global_config.paging_dir, (size_t)1U << PAGING_FILE_EXP);
+		if(unlikely(p_file.base == NULL)) {
+			logger(LOG_FATAL, "Unable to map a paging file in %s!", global_config.paging_dir);
+			abort();
+		}
+		array_init(p_file.free);
+	}
+
+	array_count_t i = array_count(p_file.free);
+	while(i--) {
+		struct paging_extent *e = &array_get_at(p_file.free, i);
+		if(e->size < size)
+			continue;
+
+		void *ret = p_file.base + e->off;
+		e->off += size;
+		e->size -= size;
+		if(!e->size)
+			array_lazy_remove_at(p_file.free, i);
+		return ret;
+	}
+
+	if(unlikely(p_file.top + size > (size_t)1U << PAGING_FILE_EXP)) {
+		logger(LOG_FATAL, "The paging file is full!");
+		abort();
+	}
+
+	void *ret = p_file.base + p_file.top;
+	p_file.top += size;
+	return ret;
+}
+
+/**
+ * @brief Release an extent of the thread paging file
+ * @param ptr a pointer returned by paging_extent_alloc()
+ * @param size the size in bytes of the extent, as passed to paging_extent_alloc()
+ */
+void paging_extent_free(void *ptr, size_t size)
+{
+	size = (size + PAGING_EXTENT_ALIGN - 1) & ~((size_t)PAGING_EXTENT_ALIGN - 1);
+	mem_file_discard(ptr, size);
+
+	size_t off = (unsigned char *)ptr - p_file.base;
+	if(off + size == p_file.top) {
+		p_file.top = off;
+		return;
+	}
+
+	struct paging_extent e = {.off = off, .size = size};
+	array_push(p_file.free, e);
+}
+
+/**
+ * @brief Move the memory of an LP to the thread paging file
+ * @param lp the LP to page out
+ */
+void paging_lp_out(struct lp_ctx *lp)
+{
+	size_t size = model_allocator_lp_page_out(&lp_cold(lp)->mm_state);
+	if(!size)
+		return;
+
+	lp_cold(lp)->paged = true;
+	stats_take(STATS_LP_PAGE_OUT, 1);
+	stats_take(STATS_LP_PAGE_OUT_SIZE, size);
+}
+
+/**
+ * @brief Move back the memory of an LP from the thread paging file
+ * @param lp the paged out LP
+ */
+void paging_lp_in(struct lp_ctx *lp)
+{
+	model_allocator_lp_page_in(&lp_cold(lp)->mm_state);
+	lp_cold(lp)->paged = false;
+	stats_take(STATS_LP_PAGE_IN, 1);
+}
+
+/**
+ * @brief Page out the LPs of the current thread which the paging policy deems idle
+ *
+ * This is called after a fresh GVT has been computed. Unless the model set its own policy, the LPs which didn't
+ * process any event in the last @a paging_idle_gvts GVT phases are paged out.
+ */
+void paging_on_gvt(void)
+{
+	if(likely(global_config.paging_dir == NULL))
+		return;
+
+	for(uint64_t k = lid_thread_first; k < lid_thread_end; ++k) {
+		struct lp_ctx *lp = &lps[k];
+		unsigned idle = fossil_epoch_current - lp->fossil_epoch;
+		if(lp_cold(lp)->paged || !idle)
+			continue;
+
+		bool evict = global_config.paging_policy != NULL ? global_config.paging_policy(lid_thread_at(k), idle) :
+		                                                   idle >= global_config.paging_idle_gvts;
+		if(evict)
+			paging_lp_out(lp);
+	}
+}
+
+/**
+ * @brief Release the paging file of the current thread
+ *
+ * The LPs must have been paged back in, or finalized, beforehand.
+ */
+void paging_fini(void)
+{
+	if(p_file.base == NULL)
+		return;
+
+	mem_file_unmap(p_file.base, (size_t)1U << PAGING_FILE_EXP);
+	array_fini(p_file.free);
+	memset(&p_file, 0, sizeof(p_file));
+}
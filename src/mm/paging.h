@@ -0,0 +1,31 @@
+/**
+ * @file mm/paging.h
+ *
+ * @brief Paging of the memory of the idle LPs to a memory-mapped file
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#pragma once
+
+#include <lp/lp.h>
+
+#include <stddef.h>
+
+extern void *paging_extent_alloc(size_t size);
+extern void paging_extent_free(void *ptr, size_t size);
+
+extern void paging_on_gvt(void);
+extern void paging_lp_out(struct lp_ctx *lp);
+extern void paging_lp_in(struct lp_ctx *lp);
+extern void paging_fini(void);
+
+/**
+ * @brief Make sure that the memory of an LP is resident, paging it in if needed
+ * @param lp the LP which is about to be accessed
+ */
+static inline void paging_lp_ensure(struct lp_ctx *lp)
+{
+	if(unlikely(lp_cold(lp)->paged))
+		paging_lp_in(lp);
+}
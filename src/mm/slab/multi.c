@@ -0,0 +1,250 @@
+/**
+ * @file mm/slab/multi.c
+ *
+ * @brief Handling of multiple slabs
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <mm/slab/multi.h>
+
+#include <core/core.h>
+#include <lp/lp.h>
+#include <mm/slab/slab.h>
+
+#include <errno.h>
+
+void model_allocator_lp_init(struct mm_state *self)
+{
+	array_init(self->slabs);
+	array_init(self->logs);
+	memset(self->partial, 0, sizeof(self->partial));
+	self->full_ckpt_size = offsetof(struct mm_checkpoint, chkps) + sizeof(struct slab *);
+	bump_arena_init(&self->bump);
+}
+
+void model_allocator_lp_fini(struct mm_state *self)
+{
+	array_count_t i = array_count(self->logs);
+	while(i--) {
+		mm_free(array_get_at(self->logs, i).c->bump);
+		mm_free(array_get_at(self->logs, i).c);
+	}
+
+	array_fini(self->logs);
+
+	i = array_count(self->slabs);
+	while(i--)
+		mm_aligned_free(array_get_at(self->slabs, i));
+
+	array_fini(self->slabs);
+
+	bump_arena_fini(&self->bump);
+}
+
+/**
+ * @brief Give back in bulk the memory of the LPs bound to the calling thread
+ *
+ * The slabs are owned by the single LPs, so there's nothing to release at once: everything is left to the OS.
+ */
+void model_allocator_thread_drop(void)
+{
+}
+
+/**
+ * @brief Move the memory of an LP to the thread paging file
+ * @param self the memory context of the LP
+ * @return the count of bytes moved, always 0 since the slabs of the LPs aren't paged out
+ */
+size_t model_allocator_lp_page_out(struct mm_state *self)
+{
+	(void)self;
+	return 0;
+}
+
+/**
+ * @brief Move back the memory of an LP from the thread paging file
+ * @param self the memory context of the LP
+ */
+void model_allocator_lp_page_in(struct mm_state *self)
+{
+	(void)self;
+}
+
+void *rs_malloc(size_t req_size)
+{
+	if(unlikely(!req_size))
+		return NULL;
+
+	if(unlikely(req_size > SLAB_HUGE_SIZE)) {
+		errno = ENOMEM;
+		logger(LOG_WARN, "LP %p requested a memory block bigger than %zu!", current_lp, SLAB_HUGE_SIZE);
+		return NULL;
+	}
+
+	struct mm_state *self = &lp_cold(current_lp)->mm_state;
+	unsigned s_class = slab_class_compute(req_size);
+	struct slab *s = self->partial[s_class];
+
+	if(unlikely(s == NULL)) {
+		s = mm_aligned_alloc(1U << SLAB_EXP, 1U << SLAB_EXP);
+		slab_init(s, s_class);
+		array_push(self->slabs, s);
+		self->partial[s_class] = s;
+		self->full_ckpt_size += slab_checkpoint_base_size(s);
+	}
+
+	void *ret = slab_malloc(s);
+	if(unlikely(s->used == s->obj_cnt))
+		self->partial[s_class] = s->next;
+
+	self->full_ckpt_size += s->obj_size;
+	return ret;
+}
+
+void *rs_calloc(size_t nmemb, size_t size)
+{
+	size_t tot = nmemb * size;
+	void *ret = rs_malloc(tot);
+
+	if(likely(ret))
+		memset(ret, 0, tot);
+
+	return ret;
+}
+
+void rs_free(void *ptr)
+{
+	if(unlikely(!ptr))
+		return;
+
+	struct mm_state *self = &lp_cold(current_lp)->mm_state;
+	struct slab *s = slab_find_by_address(ptr);
+	if(unlikely(s->used == s->obj_cnt)) {
+		s->next = self->partial[s->s_class];
+		self->partial[s->s_class] = s;
+	}
+	slab_free(s, ptr);
+	self->full_ckpt_size -= s->obj_size;
+}
+
+void *rs_realloc(void *ptr, size_t req_size)
+{
+	if(!req_size) { // Adhering to C11 standard §7.20.3.1
+		if(!ptr)
+			errno = EINVAL;
+		return NULL;
+	}
+	if(!ptr)
+		return rs_malloc(req_size);
+
+	struct slab *s = slab_find_by_address(ptr);
+	if(req_size <= SLAB_HUGE_SIZE && slab_class_compute(req_size) == s->s_class)
+		return ptr;
+
+	void *new_buffer = rs_malloc(req_size);
+	if(unlikely(new_buffer == NULL))
+		return NULL;
+
+	memcpy(new_buffer, ptr, min(req_size, s->obj_size));
+	rs_free(ptr);
+
+	return new_buffer;
+}
+
+void __write_mem(const void *ptr, size_t s)
+{
+	// the slab allocator only supports full checkpoints
+	(void)ptr;
+	(void)s;
+}
+
+void model_allocator_checkpoint_take(struct mm_state *self, array_count_t ref_i)
+{
+	struct mm_checkpoint *ckp = mm_alloc(self->full_ckpt_size);
+	ckp->ckpt_size = self->full_ckpt_size;
+	ckp->bump = bump_checkpoint_take(&self->bump);
+
+	struct mm_log mm_log = {.ref_i = ref_i, .c = ckp};
+	array_push(self->logs, mm_log);
+
+	struct slab_checkpoint *slab_ckp = (struct slab_checkpoint *)ckp->chkps;
+	array_count_t i = array_count(self->slabs);
+	while(i--)
+		slab_ckp = slab_checkpoint_take(array_get_at(self->slabs, i), slab_ckp);
+	slab_ckp->orig = NULL;
+}
+
+void model_allocator_checkpoint_next_force_full(struct mm_state *self)
+{
+	(void)self;
+}
+
+array_count_t model_allocator_checkpoint_restore(struct mm_state *self, array_count_t ref_i)
+{
+	array_count_t i = array_count(self->logs) - 1;
+	while(array_get_at(self->logs, i).ref_i > ref_i)
+		i--;
+
+	struct mm_checkpoint *ckp = array_get_at(self->logs, i).c;
+	self->full_ckpt_size = ckp->ckpt_size;
+	const struct slab_checkpoint *slab_ckp = (struct slab_checkpoint *)ckp->chkps;
+
+	memset(self->partial, 0, sizeof(self->partial));
+
+	array_count_t k = array_count(self->slabs);
+	while(k--) {
+		struct slab *s = array_get_at(self->slabs, k);
+		const struct slab_checkpoint *c = slab_checkpoint_restore(s, slab_ckp);
+		if(unlikely(c == NULL)) {
+			slab_init(s, s->s_class);
+			self->full_ckpt_size += slab_checkpoint_base_size(s);
+		} else {
+			slab_ckp = c;
+		}
+
+		if(s->used != s->obj_cnt) {
+			s->next = self->partial[s->s_class];
+			self->partial[s->s_class] = s;
+		}
+	}
+
+	bump_checkpoint_restore(&self->bump, ckp->bump);
+
+	for(array_count_t j = array_count(self->logs) - 1; j > i; --j) {
+		mm_free(array_get_at(self->logs, j).c->bump);
+		mm_free(array_get_at(self->logs, j).c);
+	}
+
+	array_count(self->logs) = i + 1;
+	return array_get_at(self->logs, i).ref_i;
+}
+
+array_count_t model_allocator_fossil_lp_collect(struct mm_state *self, array_count_t tgt_ref_i)
+{
+	array_count_t log_i = array_count(self->logs) - 1;
+	array_count_t ref_i = array_get_at(self->logs, log_i).ref_i;
+	while(ref_i > tgt_ref_i) {
+		--log_i;
+		ref_i = array_get_at(self->logs, log_i).ref_i;
+	}
+
+	array_count_t j = array_count(self->logs);
+	while(j > log_i) {
+		--j;
+		array_get_at(self->logs, j).ref_i -= ref_i;
+	}
+
+	// the oldest retained checkpoint can't rely on the discarded ones anymore
+	struct mm_checkpoint *oldest = array_get_at(self->logs, log_i).c;
+	if(log_i)
+		oldest->bump = bump_checkpoint_rebase(&self->bump, oldest->bump);
+
+	while(j--) {
+		mm_free(array_get_at(self->logs, j).c->bump);
+		mm_free(array_get_at(self->logs, j).c);
+	}
+
+	array_truncate_first(self->logs, log_i);
+	return ref_i;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file mm/slab/multi.h
+ *
+ * @brief Handling of multiple slabs
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#pragma once
+
+#include <datatypes/array.h>
+#include <mm/bump.h>
+#include <mm/slab/slab.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// The checkpoint for the multiple slabs allocator
+struct mm_checkpoint {
+	/// The total count of allocated bytes at the moment of the checkpoint
+	uint_fast32_t ckpt_size;
+	/// The checkpoint of the append-only arena, NULL if the arena has never been used
+	struct bump_checkpoint *bump;
+	/// The sequence of checkpoints of the allocated slabs (see @a slab_checkpoint)
+	unsigned char chkps[];
+};
+
+/// Binds a checkpoint together with a reference index
+struct mm_log {
+	/// The reference index, used to identify this checkpoint
+	array_count_t ref_i;
+	/// A pointer to the actual checkpoint
+	struct mm_checkpoint *c;
+};
+
+/// The checkpointable memory context assigned to a single LP
+struct mm_state {
+	/// The array of pointers to the allocated slabs for the LP, in allocation order
+	dyn_array(struct slab *) slabs;
+	/// For each size class, the list of slabs which have at least a free object
+	struct slab *partial[SLAB_CLASSES];
+	/// The array of checkpoints
+	dyn_array(struct mm_log) logs;
+	/// The total count of allocated bytes
+	uint_fast32_t full_ckpt_size;
+	/// The append-only arena
+	struct bump_arena bump;
+};
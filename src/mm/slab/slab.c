@@ -0,0 +1,120 @@
+/**
+ * @file mm/slab/slab.c
+ *
+ * @brief A size-class slab allocator
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <mm/slab/slab.h>
+
+#include <string.h>
+
+static_assert(SLAB_HUGE_SIZE % (1U << SLAB_MIN_EXP) == 0, "slab objects would break checkpoints alignment");
+
+/**
+ * @brief Initialize an empty slab
+ * @param self the slab to initialize
+ * @param s_class the size class of the objects served by @p self
+ */
+void slab_init(struct slab *self, unsigned s_class)
+{
+	self->next = NULL;
+	self->free_list = NULL;
+	self->bump = 0;
+	self->used = 0;
+	self->s_class = s_class;
+	self->obj_size = slab_class_size(s_class);
+	self->obj_cnt = SLAB_HUGE_SIZE / self->obj_size;
+	memset(self->alloc, 0, sizeof(self->alloc));
+}
+
+/**
+ * @brief Allocate an object from a slab
+ * @param self the slab, which must have at least a free object
+ * @return a pointer to the allocated object
+ */
+void *slab_malloc(struct slab *self)
+{
+	unsigned char *ret = self->free_list;
+	if(likely(ret != NULL)) {
+		self->free_list = *(void **)ret;
+	} else {
+		ret = self->base_mem + self->bump * self->obj_size;
+		++self->bump;
+	}
+
+	bitmap_set(self->alloc, (ret - self->base_mem) / self->obj_size);
+	++self->used;
+	return ret;
+}
+
+/**
+ * @brief Release an object to its slab
+ * @param self the slab which hosts the object
+ * @param ptr a pointer to the object to release
+ */
+void slab_free(struct slab *self, void *ptr)
+{
+	bitmap_reset(self->alloc, ((unsigned char *)ptr - self->base_mem) / self->obj_size);
+	*(void **)ptr = self->free_list;
+	self->free_list = ptr;
+	--self->used;
+}
+
+struct slab_checkpoint *slab_checkpoint_take(const struct slab *self, struct slab_checkpoint *ret)
+{
+	ret->orig = self;
+	size_t b_size = bitmap_required_size(self->obj_cnt);
+	memcpy(ret->data, self->alloc, b_size);
+
+#define slab_obj_copy_to_ckp(i)                                                                                        \
+	__extension__({                                                                                                \
+		memcpy(ptr, self->base_mem + (i) * self->obj_size, self->obj_size);                                    \
+		ptr += self->obj_size;                                                                                 \
+	})
+
+	unsigned char *ptr = ret->data + b_size;
+	bitmap_foreach_set(self->alloc, b_size, slab_obj_copy_to_ckp);
+
+#undef slab_obj_copy_to_ckp
+	return (struct slab_checkpoint *)ptr;
+}
+
+const struct slab_checkpoint *slab_checkpoint_restore(struct slab *self, const struct slab_checkpoint *ckp)
+{
+	if(unlikely(ckp->orig != self))
+		return NULL;
+
+	size_t b_size = bitmap_required_size(self->obj_cnt);
+	memcpy(self->alloc, ckp->data, b_size);
+
+	uint_fast32_t last = 0;
+#define slab_obj_copy_from_ckp(i)                                                                                      \
+	__extension__({                                                                                                \
+		memcpy(self->base_mem + (i) * self->obj_size, ptr, self->obj_size);                                    \
+		ptr += self->obj_size;                                                                                 \
+		last = (i) + 1;                                                                                        \
+	})
+
+	const unsigned char *ptr = ckp->data + b_size;
+	bitmap_foreach_set(self->alloc, b_size, slab_obj_copy_from_ckp);
+
+#undef slab_obj_copy_from_ckp
+
+	// the free list lived inside the free objects, which aren't checkpointed: rebuild it
+	self->bump = last;
+	self->used = 0;
+	self->free_list = NULL;
+	while(last--) {
+		if(bitmap_check(self->alloc, last)) {
+			++self->used;
+			continue;
+		}
+		void *obj = self->base_mem + last * self->obj_size;
+		*(void **)obj = self->free_list;
+		self->free_list = obj;
+	}
+
+	return (const struct slab_checkpoint *)ptr;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file mm/slab/slab.h
+ *
+ * @brief A size-class slab allocator
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#pragma once
+
+#include <core/core.h>
+#include <core/intrinsics.h>
+#include <datatypes/bitmap.h>
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// The exponent of the size of a slab; slabs are aligned to their size
+#define SLAB_EXP 16U
+/// The exponent of the allocation granularity
+#define SLAB_MIN_EXP 4U
+/// The exponent of the largest size served by the geometrically spaced classes
+#define SLAB_GEOM_MAX_EXP 14U
+/// The count of size classes: 4 linear ones, 4 for each following power of two and a single huge class
+#define SLAB_CLASSES (4U * (SLAB_GEOM_MAX_EXP - SLAB_MIN_EXP - 1U) + 1U)
+/// The maximum count of objects which can be hosted in a single slab
+#define SLAB_MAX_OBJS (1U << (SLAB_EXP - SLAB_MIN_EXP))
+/// The size of the objects of the huge size class, i.e. the largest allocation this allocator can serve
+#define SLAB_HUGE_SIZE ((1U << SLAB_EXP) - offsetof(struct slab, base_mem))
+
+/// A slab, hosting objects of a single size class
+struct slab {
+	/// The next slab of the same size class with some free objects
+	struct slab *next;
+	/// The list of released objects
+	void *free_list;
+	/// The index of the first object which has never been handed out since the last reset
+	uint_fast32_t bump;
+	/// The count of objects currently allocated
+	uint_fast32_t used;
+	/// The count of objects which fit in this slab
+	uint_fast32_t obj_cnt;
+	/// The size of the objects served by this slab
+	uint_fast32_t obj_size;
+	/// The size class of this slab
+	unsigned s_class;
+	/// Keeps track of the allocated objects
+	block_bitmap alloc[bitmap_required_size(SLAB_MAX_OBJS)];
+	/// The memory buffer served to the model
+	alignas(CACHE_LINE_SIZE) unsigned char base_mem[];
+};
+
+/// A restorable checkpoint of the memory context of a single slab
+struct slab_checkpoint {
+	/// The slab to which this checkpoint applies
+	const struct slab *orig;
+	/// The allocation bitmap, trimmed to the objects count, followed by the allocated objects contents
+	unsigned char data[];
+};
+
+/**
+ * @brief Compute the size class for a given allocation request
+ * @param req_size the requested allocation size in bytes, not greater than #SLAB_HUGE_SIZE
+ * @return the size class which serves @p req_size
+ *
+ * Up to 64 bytes the classes are spaced by 16 bytes, then each power of two interval is split in 4 classes, which
+ * bounds the internal fragmentation to 25% (for example 72 bytes are served by the 80 bytes class).
+ */
+static inline unsigned slab_class_compute(size_t req_size)
+{
+	if(req_size <= (1U << (SLAB_MIN_EXP + 2U)))
+		return (req_size - 1) >> SLAB_MIN_EXP;
+
+	if(req_size > (1U << SLAB_GEOM_MAX_EXP))
+		return SLAB_CLASSES - 1;
+
+	--req_size;
+	unsigned e = sizeof(req_size) * CHAR_BIT - 1 - intrinsics_clz(req_size);
+	return ((e - SLAB_MIN_EXP - 1) << 2U) + (req_size >> (e - 2)) - 4;
+}
+
+/**
+ * @brief Compute the size of the objects served by a size class
+ * @param s_class the size class
+ * @return the size in bytes of the objects of the class @p s_class
+ */
+static inline uint_fast32_t slab_class_size(unsigned s_class)
+{
+	if(s_class < 4)
+		return (s_class + 1) << SLAB_MIN_EXP;
+
+	if(s_class == SLAB_CLASSES - 1)
+		return SLAB_HUGE_SIZE;
+
+	unsigned e = (s_class >> 2U) + SLAB_MIN_EXP + 1;
+	return ((s_class & 3U) + 5) << (e - 2);
+}
+
+/**
+ * @brief Get the slab which contains a given object
+ * @param ptr a pointer to an object served by a slab
+ * @return the slab which hosts @p ptr
+ */
+#define slab_find_by_address(ptr) ((struct slab *)((uintptr_t)(ptr) & ~(((uintptr_t)1U << SLAB_EXP) - 1)))
+
+/**
+ * @brief Compute the size of the checkpoint of a slab, excluding the allocated objects
+ * @param self the slab
+ * @return the size in bytes of the fixed part of the checkpoint of @p self
+ */
+#define slab_checkpoint_base_size(self)                                                                                \
+	(offsetof(struct slab_checkpoint, data) + bitmap_required_size((self)->obj_cnt))
+
+extern void slab_init(struct slab *self, unsigned s_class);
+extern void *slab_malloc(struct slab *self);
+extern void slab_free(struct slab *self, void *ptr);
+
+extern struct slab_checkpoint *slab_checkpoint_take(const struct slab *self, struct slab_checkpoint *data);
+extern const struct slab_checkpoint *slab_checkpoint_restore(struct slab *self, const struct slab_checkpoint *data);
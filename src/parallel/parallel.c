@@ -14,16 +14,20 @@
 #include <datatypes/msg_queue.h>
 #include <distributed/mpi.h>
 #include <gvt/fossil.h>
+#include <log/comm_prof.h>
 #include <log/stats.h>
 #include <mm/msg_allocator.h>
+#include <mm/paging.h>
 
 static void worker_thread_init(rid_t this_rid)
 {
 	rid = this_rid;
 	stats_init();
+	comm_prof_init();
 	auto_ckpt_init();
 	msg_allocator_init();
 	msg_queue_init();
+	mpi_remote_msg_init();
 	sync_thread_barrier();
 	lp_init();
 
@@ -50,7 +54,10 @@ static void worker_thread_fini(void)
 		mpi_node_barrier();
 	}
 
+	mpi_remote_msg_fini();
+	comm_prof_fini();
 	lp_fini();
+	paging_fini();
 	msg_queue_fini();
 	sync_thread_barrier();
 	msg_allocator_fini();
@@ -62,17 +69,24 @@ static thrd_ret_t THREAD_CALL_CONV parallel_thread_run(void *rid_arg)
 
 	while(likely(termination_cant_end())) {
 		mpi_remote_msg_handle();
-
-		unsigned i = 64;
-		while(i--)
-			process_msg();
+		msg_allocator_at_gvt_collect();
+
+		if(likely(!mpi_remote_msg_throttled())) {
+			unsigned i = 64;
+			while(i--)
+				process_msg();
+		} else {
+			stats_take(STATS_REMOTE_CREDIT_STALL, 1);
+		}
 
 		simtime_t current_gvt = gvt_phase_run();
 		if(unlikely(current_gvt != 0.0)) {
 			termination_on_gvt(current_gvt);
 			auto_ckpt_on_gvt();
 			fossil_on_gvt(current_gvt);
+			paging_on_gvt();
 			msg_allocator_on_gvt(current_gvt);
+			mpi_remote_msg_on_gvt();
 			stats_on_gvt(current_gvt);
 		}
 	}
@@ -85,17 +99,23 @@ static thrd_ret_t THREAD_CALL_CONV parallel_thread_run(void *rid_arg)
 static void parallel_global_init(void)
 {
 	stats_global_init();
+	comm_prof_global_init();
+	placement_global_init();
 	lp_global_init();
 	msg_queue_global_init();
+	msg_allocator_global_init();
 	termination_global_init();
 	gvt_global_init();
 }
 
 static void parallel_global_fini(void)
 {
+	msg_allocator_global_fini();
 	msg_queue_global_fini();
 	lp_global_fini();
+	placement_global_fini();
 	stats_global_fini();
+	comm_prof_global_fini();
 }
 
 int parallel_simulation(void)
@@ -11,6 +11,7 @@
 #include <arch/timer.h>
 #include <datatypes/heap.h>
 #include <lib/random/random.h>
+#include <log/comm_prof.h>
 #include <log/stats.h>
 #include <lp/common.h>
 #include <mm/msg_allocator.h>
@@ -25,11 +26,16 @@ static void serial_simulation_init(void)
 {
 	stats_global_init();
 	stats_init();
+	comm_prof_global_init();
+	comm_prof_init();
+	msg_allocator_global_init();
 	msg_allocator_init();
 	heap_init(queue);
 
-	lps = mm_alloc(sizeof(*lps) * global_config.lps);
+	lps = mm_aligned_alloc(CACHE_LINE_SIZE, sizeof(*lps) * global_config.lps);
 	memset(lps, 0, sizeof(*lps) * global_config.lps);
+	lps_cold = mm_alloc(sizeof(*lps_cold) * global_config.lps);
+	memset(lps_cold, 0, sizeof(*lps_cold) * global_config.lps);
 
 	n_lps_node = global_config.lps;
 
@@ -38,7 +44,7 @@ static void serial_simulation_init(void)
 
 		lp->termination_t = -1;
 
-		model_allocator_lp_init(&lp->mm_state);
+		model_allocator_lp_init(&lps_cold[i].mm_state);
 
 		current_lp = lp;
 		lp->rng_ctx = rs_malloc(sizeof(*lp->rng_ctx));
@@ -66,17 +72,25 @@ static void serial_simulation_fini(void)
 		struct lp_ctx *lp = &lps[i];
 		current_lp = lp;
 		global_config.dispatcher(i, 0, LP_FINI, NULL, 0, lp->state_pointer);
-		model_allocator_lp_fini(&lp->mm_state);
+		if(!global_config.fast_teardown)
+			model_allocator_lp_fini(&lps_cold[i].mm_state);
 	}
 
-	for(array_count_t i = 0; i < array_count(queue); ++i)
-		msg_allocator_free(array_get_at(queue, i));
+	if(global_config.fast_teardown)
+		model_allocator_thread_drop();
+	else
+		for(array_count_t i = 0; i < array_count(queue); ++i)
+			msg_allocator_free(array_get_at(queue, i));
 
-	mm_free(lps);
+	mm_aligned_free(lps);
+	mm_free(lps_cold);
 
 	heap_fini(queue);
 	msg_allocator_fini();
+	msg_allocator_global_fini();
+	comm_prof_fini();
 	stats_global_fini();
+	comm_prof_global_fini();
 }
 
 /**
@@ -128,6 +142,8 @@ static int serial_simulation_run(void)
 void ScheduleNewEvent_serial(lp_id_t receiver, simtime_t timestamp, unsigned event_type, const void *payload,
     unsigned payload_size)
 {
+	comm_prof_sample(current_lp - lps, receiver);
+
 	struct lp_msg *msg = msg_allocator_pack(receiver, timestamp, event_type, payload, payload_size);
 	msg->raw_flags = 0;
 
@@ -0,0 +1,116 @@
+/**
+ * @file test/bench/mm.c
+ *
+ * @brief Benchmark of the model memory allocator
+ *
+ * A single mock LP fills its memory with small objects, checkpoints it, churns the objects with random frees and
+ * allocations and finally frees everything. Build it once per allocator backend to compare them.
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <test.h>
+
+#include <lp/lp.h>
+#include <mm/model_allocator.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/// The count of objects kept alive by the benchmark
+#define BENCH_LIVE 100000U
+/// The count of free and malloc pairs in the churn phase
+#define BENCH_CHURN 4000000U
+
+static void *objs[BENCH_LIVE];
+
+/**
+ * @brief Get the current time
+ * @return the value of the monotonic clock in seconds
+ */
+static double bench_now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Get the resident set size of this process
+ * @return the resident set size in KiB, 0 if it can't be read
+ */
+static long bench_rss_kb(void)
+{
+	FILE *f = fopen("/proc/self/status", "r");
+	if(f == NULL)
+		return 0;
+
+	char line[256];
+	long ret = 0;
+	while(fgets(line, sizeof(line), f))
+		if(!strncmp(line, "VmRSS:", 6))
+			sscanf(line + 6, "%ld", &ret);
+
+	fclose(f);
+	return ret;
+}
+
+/**
+ * @brief Run the benchmark phases with objects of a given size and print the results
+ * @param size the size in bytes of the allocated objects
+ */
+static void bench_run(size_t size)
+{
+	current_lp = test_lp_mock_get();
+	struct mm_state *mm = &lp_cold(current_lp)->mm_state;
+	model_allocator_lp_init(mm);
+
+	long rss_start = bench_rss_kb();
+	double t_fill = bench_now();
+	for(unsigned i = 0; i < BENCH_LIVE; ++i) {
+		objs[i] = rs_malloc(size);
+		memset(objs[i], (int)i, size);
+	}
+	double t_fill_end = bench_now();
+	long rss_filled = bench_rss_kb();
+
+	double t_ckpt = bench_now();
+	model_allocator_checkpoint_take(mm, 0);
+	double t_ckpt_end = bench_now();
+	size_t ckpt_size = array_peek(mm->logs).c->ckpt_size;
+
+	// xorshift64, to keep the random draws out of the rollbackable LP random number generator
+	uint64_t x = 88172645463325252ULL;
+	double t_churn = bench_now();
+	for(unsigned i = 0; i < BENCH_CHURN; ++i) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		unsigned k = x % BENCH_LIVE;
+		rs_free(objs[k]);
+		objs[k] = rs_malloc(size);
+		*(unsigned char *)objs[k] = (unsigned char)i;
+	}
+	double t_free = bench_now();
+	for(unsigned i = 0; i < BENCH_LIVE; ++i)
+		rs_free(objs[i]);
+	double t_end = bench_now();
+
+	double rss_mib = (double)(rss_filled - rss_start) / 1024.0;
+	printf("%zu B objects:\n", size);
+	printf("  fill:       %.1f Mops/s\n", BENCH_LIVE / (t_fill_end - t_fill) / 1e6);
+	printf("  churn:      %.1f Mpairs/s (free + malloc)\n", BENCH_CHURN / (t_free - t_churn) / 1e6);
+	printf("  free all:   %.1f Mops/s\n", BENCH_LIVE / (t_end - t_free) / 1e6);
+	printf("  RSS:        +%.1f MiB, %.0f B per object\n", rss_mib, rss_mib * 1048576.0 / BENCH_LIVE);
+	printf("  checkpoint: %.1f MiB in %.1f ms\n", (double)ckpt_size / 1048576.0, (t_ckpt_end - t_ckpt) * 1e3);
+
+	model_allocator_lp_fini(mm);
+}
+
+int main(void)
+{
+	bench_run(72);
+	bench_run(136);
+	return 0;
+}
@@ -10,20 +10,31 @@
 */
 #include <lp/lp.h>
 
-struct lp_mock {
-	struct lp_ctx lp;
-	struct rng_ctx rng_ctx;
-};
+#include <test.h>
 
-static _Thread_local struct lp_mock lp_mock;
+/// The maximum count of threads which can concurrently use a mock LP
+#define TEST_LP_MOCKS_MAX 1024
+
+static struct lp_ctx lp_mocks[TEST_LP_MOCKS_MAX];
+static struct lp_cold_ctx lp_cold_mocks[TEST_LP_MOCKS_MAX];
+static struct rng_ctx rng_mocks[TEST_LP_MOCKS_MAX];
 
 struct lp_ctx *test_lp_mock_get(void)
 {
-	lp_mock.lp.rng_ctx = &lp_mock.rng_ctx;
-	lp_mock.rng_ctx.state[0] = 7319936632422683443ULL;
-	lp_mock.rng_ctx.state[1] = 2268344373199366324ULL;
-	lp_mock.rng_ctx.state[2] = 3443862242366399137ULL;
-	lp_mock.rng_ctx.state[3] = 2366399137344386224ULL;
+	unsigned i = test_parallel_thread_id();
+	if(i >= TEST_LP_MOCKS_MAX)
+		abort();
+
+	// the cold contexts of the LPs are found through their index in the LP contexts array
+	lps = lp_mocks;
+	lps_cold = lp_cold_mocks;
+
+	struct lp_ctx *lp = &lp_mocks[i];
+	lp->rng_ctx = &rng_mocks[i];
+	rng_mocks[i].state[0] = 7319936632422683443ULL;
+	rng_mocks[i].state[1] = 2268344373199366324ULL;
+	rng_mocks[i].state[2] = 3443862242366399137ULL;
+	rng_mocks[i].state[3] = 2366399137344386224ULL;
 
-	return &lp_mock.lp;
+	return lp;
 }
@@ -14,12 +14,15 @@
 #include <memory.h>
 
 static _Atomic bool initialized = false;
+static _Atomic unsigned finalized = 0;
 
 static void DummyProcessEvent(_unused lp_id_t me, _unused simtime_t now, _unused unsigned event_type,
     _unused const void *event_content, _unused unsigned event_size, _unused void *st)
 {
-	if(event_type == LP_FINI)
+	if(event_type == LP_FINI) {
+		++finalized;
 		return;
+	}
 	initialized = true;
 	test_thread_sleep(20);
 	ScheduleNewEvent(0, now + 1.0, 0, NULL, 0);
@@ -36,6 +39,9 @@ static struct simulation_configuration serial_conf = {
 static struct simulation_configuration parallel_conf = {
     .lps = 1, .dispatcher = DummyProcessEvent, .committed = DummyCanEnd, .serial = false};
 
+static struct simulation_configuration fast_teardown_conf = {
+    .lps = 1, .dispatcher = DummyProcessEvent, .committed = DummyCanEnd, .serial = true, .fast_teardown = true};
+
 static int force_termination_test(void *conf)
 {
 	if(test_parallel_thread_id()) {
@@ -46,7 +52,10 @@ static int force_termination_test(void *conf)
 		return 0;
 	}
 	RootsimInit((struct simulation_configuration *)conf);
-	return RootsimRun();
+	finalized = 0;
+	int ret = RootsimRun();
+	// the models are notified even when the memory is dropped in bulk
+	return ret || finalized != ((struct simulation_configuration *)conf)->lps;
 }
 
 int main(void)
@@ -54,5 +63,7 @@ int main(void)
 	initialized = false;
 	test_parallel("Test forced termination serial", force_termination_test, &serial_conf, 2);
 	initialized = false;
+	test_parallel("Test forced termination with fast teardown", force_termination_test, &fast_teardown_conf, 2);
+	initialized = false;
 	test_parallel("Test forced termination parallel", force_termination_test, &parallel_conf, 2);
 }
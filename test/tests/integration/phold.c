@@ -10,7 +10,9 @@
 
 #include <ROOT-Sim.h>
 
+#include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
 
 #ifndef NUM_LPS
 #define NUM_LPS 8192
@@ -20,12 +22,69 @@
 #define NUM_THREADS 0
 #endif
 
+#ifndef TERMINATION_TIME
+#define TERMINATION_TIME 1000
+#endif
+
+#ifndef GVT_PERIOD
+#define GVT_PERIOD 1000
+#endif
+
+#ifndef STATS_FILE
+#define STATS_FILE "phold"
+#endif
+
+#ifndef CORE_BINDING
+#define CORE_BINDING true
+#endif
+
+#ifndef MPI_FUNNELED
+#define MPI_FUNNELED false
+#endif
+
+#ifndef REMOTE_CREDIT
+#define REMOTE_CREDIT 0
+#endif
+
+/// The size in bytes of the payload carried by the large events, 0 to send only small events
+#ifndef LARGE_PAYLOAD_SIZE
+#define LARGE_PAYLOAD_SIZE 0
+#endif
+
 #define EVENT 1
 
 struct phold_message {
 	long int dummy_data;
 };
 
+#if LARGE_PAYLOAD_SIZE
+/// The probability that an event carries a large payload
+static simtime_t p_large = 0.05;
+
+static void large_payload_fill(unsigned char *payload, lp_id_t sender)
+{
+	memcpy(payload, &sender, sizeof(sender));
+	for(unsigned i = sizeof(sender); i < LARGE_PAYLOAD_SIZE; ++i)
+		payload[i] = (unsigned char)(sender + i);
+}
+
+static void large_payload_check(lp_id_t me, const void *content, unsigned size)
+{
+	if(size == sizeof(struct phold_message))
+		return;
+
+	unsigned char expected[LARGE_PAYLOAD_SIZE];
+	lp_id_t sender = 0;
+	if(size == LARGE_PAYLOAD_SIZE)
+		memcpy(&sender, content, sizeof(sender));
+	large_payload_fill(expected, sender);
+	if(size != LARGE_PAYLOAD_SIZE || sender >= NUM_LPS || memcmp(content, expected, LARGE_PAYLOAD_SIZE)) {
+		fprintf(stderr, "LP %" PRIu64 " received a corrupted message\n", me);
+		abort();
+	}
+}
+#endif
+
 static simtime_t p_remote = 0.25;
 static simtime_t mean = 1.0;
 static simtime_t lookahead = 0.0;
@@ -51,6 +110,15 @@ void ProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, _unused const
 			if(Random() <= p_remote)
 				dest = (lp_id_t)(Random() * NUM_LPS);
 
+#if LARGE_PAYLOAD_SIZE
+			large_payload_check(me, content, size);
+			if(Random() <= p_large) {
+				unsigned char payload[LARGE_PAYLOAD_SIZE];
+				large_payload_fill(payload, me);
+				ScheduleNewEvent(dest, now + Expent(mean) + lookahead, EVENT, payload, LARGE_PAYLOAD_SIZE);
+				break;
+			}
+#endif
 			ScheduleNewEvent(dest, now + Expent(mean) + lookahead, EVENT, &new_event, sizeof(new_event));
 			break;
 
@@ -68,16 +136,18 @@ bool CanEnd(_unused lp_id_t me, _unused const void *snapshot)
 struct simulation_configuration conf = {
     .lps = NUM_LPS,
     .n_threads = NUM_THREADS,
-    .termination_time = 1000,
-    .gvt_period = 1000,
+    .termination_time = TERMINATION_TIME,
+    .gvt_period = GVT_PERIOD,
     .log_level = LOG_INFO,
-    .stats_file = "phold",
+    .stats_file = STATS_FILE,
     .ckpt_interval = 0,
     .prng_seed = 0,
-    .core_binding = true,
+    .core_binding = CORE_BINDING,
     .serial = false,
     .dispatcher = ProcessEvent,
     .committed = CanEnd,
+    .mpi_funneled = MPI_FUNNELED,
+    .remote_credit = REMOTE_CREDIT,
 };
 
 int main(void)
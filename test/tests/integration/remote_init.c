@@ -0,0 +1,99 @@
+/**
+ * @file test/tests/integration/remote_init.c
+ *
+ * @brief Test: remote messages sent while the LPs are initialized
+ *
+ * The first half of the LPs sends a message to the second half while processing LP_INIT. With the LPs split in blocks
+ * across two nodes, this sends at once much more data than the transport buffers can hold, while the receiving node
+ * is already done with its own initialization.
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <test.h>
+
+#include <ROOT-Sim.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NUM_LPS 40000
+#define PAYLOAD_SIZE 64
+
+#define EVENT 1
+
+struct remote_init_state {
+	unsigned received;
+};
+
+static void payload_fill(unsigned char payload[PAYLOAD_SIZE], lp_id_t sender)
+{
+	for(unsigned i = 0; i < PAYLOAD_SIZE; ++i)
+		payload[i] = (unsigned char)(sender + i);
+}
+
+void ProcessEvent(lp_id_t me, _unused simtime_t now, unsigned event_type, const void *content, unsigned size, void *s)
+{
+	struct remote_init_state *state = s;
+	unsigned char payload[PAYLOAD_SIZE];
+
+	switch(event_type) {
+		case LP_INIT:
+			state = rs_malloc(sizeof(*state));
+			state->received = 0;
+			SetState(state);
+			if(me < NUM_LPS / 2) {
+				payload_fill(payload, me);
+				ScheduleNewEvent(me + NUM_LPS / 2, 1.0, EVENT, payload, sizeof(payload));
+			}
+			break;
+
+		case EVENT:
+			payload_fill(payload, me - NUM_LPS / 2);
+			if(size != PAYLOAD_SIZE || memcmp(content, payload, PAYLOAD_SIZE)) {
+				fprintf(stderr, "LP %" PRIu64 " received a corrupted message\n", me);
+				abort();
+			}
+			++state->received;
+			break;
+
+		case LP_FINI:
+			if(state->received != (me >= NUM_LPS / 2)) {
+				fprintf(stderr, "LP %" PRIu64 " received %u messages\n", me, state->received);
+				abort();
+			}
+			rs_free(state);
+			break;
+
+		default:
+			fprintf(stderr, "Unknown event type\n");
+			abort();
+	}
+}
+
+bool CanEnd(_unused lp_id_t me, _unused const void *snapshot)
+{
+	return false;
+}
+
+struct simulation_configuration conf = {
+    .lps = NUM_LPS,
+    .n_threads = 1,
+    .termination_time = 10,
+    .gvt_period = 1000,
+    .log_level = LOG_INFO,
+    .stats_file = NULL,
+    .ckpt_interval = 0,
+    .prng_seed = 0,
+    .core_binding = false,
+    .serial = false,
+    .dispatcher = ProcessEvent,
+    .committed = CanEnd,
+};
+
+int main(void)
+{
+	RootsimInit(&conf);
+	return RootsimRun();
+}
@@ -0,0 +1,168 @@
+/**
+ * @file test/tests/lp/placement.c
+ *
+ * @brief Test: placement of the LPs on nodes and threads
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <test.h>
+
+#include <core/core.h>
+#include <log/comm_prof.h>
+#include <log/log.h>
+#include <lp/lp.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TORUS_SIDE 32U
+#define TORUS_THREADS 16U
+#define CLUSTERS_CNT 8U
+#define PROFILE_LPS 4096U
+#define PROFILE_PATH "test_placement_profile.txt"
+
+static int placement_check(void)
+{
+	int errs = 0;
+	lp_id_t avg = global_config.lps / ((lp_id_t)n_nodes * global_config.n_threads);
+	for(rid_t i = 0; i < global_config.n_threads; ++i) {
+		lp_id_t cnt = placement_thread_first[i + 1] - placement_thread_first[i];
+		errs += cnt == 0 || cnt > avg * 104 / 100 + 1;
+		for(lp_id_t k = placement_thread_first[i]; k < placement_thread_first[i + 1]; ++k) {
+			struct lp_place p = placement_lps[placement_order[k]];
+			errs += p.nid != nid || p.rid != i;
+			errs += lid_to_nid(placement_order[k]) != nid || lid_to_rid(placement_order[k]) != i;
+			errs += p.idx != k;
+		}
+	}
+
+	// the LP contexts are allocated only for the LPs of this node and indexed by their position
+	lp_global_init();
+	errs += n_lps_node != placement_thread_first[global_config.n_threads];
+	for(lp_id_t k = 0; k < n_lps_node; ++k)
+		errs += lid_to_lp(placement_order[k]) != &lps[k] || lp_id_get(&lps[k]) != placement_order[k];
+	lp_global_fini();
+	return errs;
+}
+
+static int topology_placement_test(_unused void *_)
+{
+	int errs = 0;
+	struct topology *topology = InitializeTopology(TOPOLOGY_TORUS, TORUS_SIDE, TORUS_SIDE);
+	global_config.lps = TORUS_SIDE * TORUS_SIDE;
+	global_config.n_threads = TORUS_THREADS;
+	global_config.placement_topology = topology;
+	n_nodes = 1;
+	nid = 0;
+
+	placement_global_init();
+	errs += placement_lps == NULL;
+	errs += placement_check();
+
+	// the block placement cuts the torus in thin strips, a good placement finds more compact parts
+	unsigned cut = 0, block_cut = 0;
+	for(lp_id_t i = 0; i < global_config.lps; ++i) {
+		for(enum topology_direction d = DIRECTION_E; d <= DIRECTION_S; ++d) {
+			lp_id_t j = GetReceiver(i, topology, d);
+			cut += placement_lps[i].rid != placement_lps[j].rid;
+			block_cut += i * TORUS_THREADS / global_config.lps != j * TORUS_THREADS / global_config.lps;
+		}
+	}
+	errs += cut >= block_cut;
+
+	placement_global_fini();
+	errs += placement_lps != NULL;
+	global_config.placement_topology = NULL;
+	ReleaseTopology(topology);
+	return errs;
+}
+
+static int profile_placement_test(_unused void *_)
+{
+	int errs = 0;
+
+	// the LPs talk mostly within clusters of interleaved ids, which the block placement splits evenly
+	FILE *f = fopen(PROFILE_PATH, "w");
+	fprintf(f, "# test profile\n");
+	for(lp_id_t i = 0; i < PROFILE_LPS; ++i) {
+		for(unsigned k = 0; k < 4; ++k) {
+			lp_id_t j = (test_random_range(PROFILE_LPS / CLUSTERS_CNT) * CLUSTERS_CNT + i % CLUSTERS_CNT);
+			fprintf(f, "%lu %lu %lu\n", (unsigned long)i, (unsigned long)j, 10 + (unsigned long)test_random_range(10));
+		}
+		fprintf(f, "%lu %lu 1\n", (unsigned long)i, (unsigned long)test_random_range(PROFILE_LPS));
+	}
+	fclose(f);
+
+	global_config.lps = PROFILE_LPS;
+	global_config.n_threads = 4;
+	global_config.placement_profile = PROFILE_PATH;
+	n_nodes = 2;
+
+	struct lp_place *places[2];
+	for(nid = 0; nid < n_nodes; ++nid) {
+		placement_global_init();
+		errs += placement_lps == NULL;
+		errs += placement_check();
+		places[nid] = malloc(PROFILE_LPS * sizeof(*places[nid]));
+		memcpy(places[nid], placement_lps, PROFILE_LPS * sizeof(*places[nid]));
+		placement_global_fini();
+	}
+
+	// every node must compute the same placement, which keeps the clusters together
+	unsigned split = 0;
+	for(lp_id_t i = 0; i < PROFILE_LPS; ++i) {
+		errs += places[0][i].nid != places[1][i].nid || places[0][i].rid != places[1][i].rid;
+		lp_id_t j = (i + CLUSTERS_CNT) % PROFILE_LPS;
+		split += places[0][i].nid != places[0][j].nid || places[0][i].rid != places[0][j].rid;
+	}
+	errs += split > PROFILE_LPS / 20;
+
+	free(places[0]);
+	free(places[1]);
+	remove(PROFILE_PATH);
+	global_config.placement_profile = NULL;
+	n_nodes = 1;
+	nid = 0;
+	return errs;
+}
+
+static int fallback_placement_test(_unused void *_)
+{
+	int errs = 0;
+	struct topology *topology = InitializeTopology(TOPOLOGY_RING, 6);
+	global_config.lps = 6;
+	global_config.n_threads = 4;
+	global_config.placement_topology = topology;
+	n_nodes = 2;
+
+	placement_global_init();
+	errs += placement_lps != NULL;
+
+	global_config.placement_topology = NULL;
+	n_nodes = 1;
+	ReleaseTopology(topology);
+	return errs;
+}
+
+static int comm_edges_compact_test(_unused void *_)
+{
+	int errs = 0;
+	struct comm_edge edges[] = {{3, 1, 1}, {0, 2, 1}, {3, 1, 2}, {0, 1, 4}, {0, 2, 3}};
+	errs += comm_edges_compact(edges, 5) != 3;
+	errs += edges[0].from != 0 || edges[0].to != 1 || edges[0].cnt != 4;
+	errs += edges[1].from != 0 || edges[1].to != 2 || edges[1].cnt != 4;
+	errs += edges[2].from != 3 || edges[2].to != 1 || edges[2].cnt != 3;
+	errs += comm_edges_compact(edges, 0) != 0;
+	return errs;
+}
+
+int main(void)
+{
+	log_init(stdout);
+
+	test("Testing communication edges compaction", comm_edges_compact_test, NULL);
+	test("Testing LP placement from a topology", topology_placement_test, NULL);
+	test("Testing LP placement from a communication profile", profile_placement_test, NULL);
+	test("Testing LP placement fallback", fallback_placement_test, NULL);
+}
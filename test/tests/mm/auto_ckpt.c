@@ -0,0 +1,109 @@
+/**
+ * @file test/tests/mm/auto_ckpt.c
+ *
+ * @brief Test: checkpointing interval selection policies
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <test.h>
+
+#include <arch/mem.h>
+#include <core/core.h>
+#include <log/log.h>
+#include <mm/auto_ckpt.h>
+
+#define STATE_SIZE 4096U
+
+/**
+ * @brief Simulate a processing window of a LP and compute its new checkpointing interval
+ * @param auto_ckpt the auto checkpoint counters of the LP
+ * @param prof the auto checkpoint profiling data of the LP
+ * @param ckpt_time the time spent checkpointing the LP in the window
+ * @param sil_time the time spent in silent execution of the LP in the window
+ * @return the checkpointing interval selected for the LP
+ */
+static unsigned window_run(struct auto_ckpt *auto_ckpt, struct auto_ckpt_prof *prof, uint64_t ckpt_time,
+    uint64_t sil_time)
+{
+	for(unsigned i = 0; i < 1000; ++i)
+		auto_ckpt_register_good(auto_ckpt);
+	for(unsigned i = 0; i < 10; ++i)
+		auto_ckpt_register_bad(prof);
+
+	auto_ckpt_register_ckpt(prof, ckpt_time, 4 * STATE_SIZE);
+	auto_ckpt_register_silent(prof, sil_time, 100);
+	auto_ckpt_recompute(auto_ckpt, prof, STATE_SIZE);
+	return auto_ckpt_interval_get(auto_ckpt);
+}
+
+static int thread_policy_test(_unused void *_)
+{
+	struct auto_ckpt a, b;
+	struct auto_ckpt_prof a_p, b_p;
+	global_config.ckpt_policy = CKPT_POLICY_THREAD;
+	auto_ckpt_init();
+	auto_ckpt_lp_init(&a, &a_p);
+	auto_ckpt_lp_init(&b, &b_p);
+
+	// without per-LP profiling, different costs must lead to the same interval
+	unsigned ia = window_run(&a, &a_p, 1000, 100000);
+	unsigned ib = window_run(&b, &b_p, 100000, 1000);
+	test_assert(ia >= 1);
+	test_assert(ia == ib);
+	return 0;
+}
+
+static int lp_policy_test(_unused void *_)
+{
+	struct auto_ckpt a, b;
+	struct auto_ckpt_prof a_p, b_p;
+	global_config.ckpt_policy = CKPT_POLICY_LP;
+	auto_ckpt_init();
+	auto_ckpt_lp_init(&a, &a_p);
+	auto_ckpt_lp_init(&b, &b_p);
+
+	// the first window only builds up the profiles
+	window_run(&a, &a_p, 1000, 100000);
+	window_run(&b, &b_p, 100000, 1000);
+
+	// cheap checkpoints and expensive silent executions call for shorter intervals
+	unsigned ia = window_run(&a, &a_p, 1000, 100000);
+	unsigned ib = window_run(&b, &b_p, 100000, 1000);
+	test_assert(ia >= 1);
+	test_assert(ia < ib);
+	return 0;
+}
+
+static int memory_policy_test(_unused void *_)
+{
+	struct auto_ckpt a, b;
+	struct auto_ckpt_prof a_p, b_p;
+	global_config.ckpt_policy = CKPT_POLICY_THREAD;
+	auto_ckpt_init();
+	auto_ckpt_lp_init(&a, &a_p);
+	unsigned ia = window_run(&a, &a_p, 1000, 1000);
+
+	if(mem_stat_rss_current_get() == 0)
+		return 0; // no resident set size information on this platform
+
+	// a tiny budget is always exceeded, so intervals must be stretched
+	global_config.ckpt_policy = CKPT_POLICY_MEMORY;
+	global_config.ckpt_mem_budget = 1;
+	auto_ckpt_init();
+	auto_ckpt_on_gvt();
+	auto_ckpt_lp_init(&b, &b_p);
+	unsigned ib = window_run(&b, &b_p, 1000, 1000);
+	test_assert(ib > 5 * ia);
+	return 0;
+}
+
+int main(void)
+{
+	log_init(stdout);
+	mem_stat_setup();
+
+	test("Testing thread checkpointing policy", thread_policy_test, NULL);
+	test("Testing per LP checkpointing policy", lp_policy_test, NULL);
+	test("Testing memory checkpointing policy", memory_policy_test, NULL);
+}
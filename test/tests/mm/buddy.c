@@ -12,9 +12,11 @@
 
 #include <framework/rng.h>
 
+#include <log/stats.h>
 #include <lp/lp.h>
 #include <mm/buddy/buddy.h>
 #include <mm/model_allocator.h>
+#include <mm/paging.h>
 
 #include <stdlib.h>
 
@@ -39,7 +41,7 @@ static int block_size_test(struct mm_state *mm, unsigned b_exp)
 
 		for(unsigned j = 0; j < block_size / sizeof(uint64_t); ++j) {
 			allocations[i][j] = rng_random_u(&b_rng);
-			//__write_mem(&allocations[i][j], sizeof(allocations[i][j]));
+			__write_mem(&allocations[i][j], sizeof(allocations[i][j]));
 		}
 	}
 
@@ -50,7 +52,7 @@ static int block_size_test(struct mm_state *mm, unsigned b_exp)
 	for(unsigned i = 0; i < allocations_cnt; ++i) {
 		for(unsigned j = 0; j < block_size / sizeof(uint64_t); ++j) {
 			allocations[i][j] = rng_random_u(&b_rng);
-			//__write_mem(&allocations[i][j], sizeof(allocations[i][j]));
+			__write_mem(&allocations[i][j], sizeof(allocations[i][j]));
 		}
 	}
 
@@ -59,7 +61,7 @@ static int block_size_test(struct mm_state *mm, unsigned b_exp)
 	for(unsigned i = 0; i < allocations_cnt; ++i) {
 		for(unsigned j = 0; j < block_size / sizeof(uint64_t); ++j) {
 			allocations[i][j] = rng_random_u(&b_rng);
-			//__write_mem(&allocations[i][j], sizeof(allocations[i][j]));
+			__write_mem(&allocations[i][j], sizeof(allocations[i][j]));
 		}
 	}
 
@@ -89,16 +91,370 @@ static int block_size_test(struct mm_state *mm, unsigned b_exp)
 	return errs > 0;
 }
 
+static int realloc_test(struct mm_state *mm)
+{
+	int errs = 0;
+	unsigned cnt = (1 << (B_TOTAL_EXP - 1)) / sizeof(uint64_t);
+	test_rng_state b_rng, b_chk;
+	rng_init(&b_rng, BUDDY_TEST_SEED);
+	b_chk = b_rng;
+
+	uint64_t *mem = rs_malloc(1 << B_BLOCK_EXP);
+	for(unsigned j = 0; j < (1 << B_BLOCK_EXP) / sizeof(uint64_t); ++j)
+		mem[j] = rng_random_u(&b_rng);
+	__write_mem(mem, 1 << B_BLOCK_EXP);
+
+	// the right siblings are free, so this must happen in place
+	uint64_t *grown = rs_realloc(mem, cnt * sizeof(uint64_t));
+	errs += grown != mem;
+	for(unsigned j = (1 << B_BLOCK_EXP) / sizeof(uint64_t); j < cnt; ++j)
+		grown[j] = rng_random_u(&b_rng);
+	__write_mem(grown, cnt * sizeof(uint64_t));
+
+	model_allocator_checkpoint_take(mm, 0);
+
+	// the freed halves must be available for new allocations
+	uint64_t *shrunk = rs_realloc(grown, (1 << B_BLOCK_EXP) + 1);
+	errs += shrunk != grown;
+	void *other = rs_malloc(1 << (B_TOTAL_EXP - 2));
+	errs += other == NULL;
+	errs += (unsigned char *)other < (unsigned char *)shrunk + (1 << (B_BLOCK_EXP + 1));
+	errs += (unsigned char *)other >= (unsigned char *)shrunk + (1 << (B_TOTAL_EXP - 1));
+	rs_free(other);
+
+	rs_free(shrunk);
+	model_allocator_checkpoint_restore(mm, 0);
+
+	for(unsigned j = 0; j < cnt; ++j)
+		errs += grown[j] != rng_random_u(&b_chk);
+
+	rs_free(grown);
+	return errs > 0;
+}
+
+static int fragmented_test(struct mm_state *mm)
+{
+	int errs = 0;
+	unsigned cnt = 1 << (B_TOTAL_EXP - B_BLOCK_EXP);
+	unsigned words = (1 << B_BLOCK_EXP) / sizeof(uint64_t);
+	test_rng_state b_rng, b_chk;
+	rng_init(&b_rng, BUDDY_TEST_SEED);
+	uint64_t **allocations = malloc(cnt * sizeof(uint64_t *));
+
+	for(unsigned i = 0; i < cnt; ++i)
+		allocations[i] = rs_malloc(1 << B_BLOCK_EXP);
+
+	// leave runs of allocated blocks of different lengths
+	for(unsigned i = 0; i < cnt; ++i) {
+		if(i % 7 == 3 || i % 11 == 5) {
+			rs_free(allocations[i]);
+			allocations[i] = NULL;
+		}
+	}
+
+	for(unsigned i = 0; i < cnt; ++i) {
+		for(unsigned j = 0; allocations[i] && j < words; ++j)
+			allocations[i][j] = rng_random_u(&b_rng);
+		__write_mem(allocations[i], allocations[i] ? 1 << B_BLOCK_EXP : 0);
+	}
+
+	model_allocator_checkpoint_take(mm, 0);
+	b_chk = b_rng;
+
+	for(unsigned i = 0; i < cnt; ++i) {
+		for(unsigned j = 0; allocations[i] && j < words; ++j)
+			allocations[i][j] = rng_random_u(&b_rng);
+		__write_mem(allocations[i], allocations[i] ? 1 << B_BLOCK_EXP : 0);
+	}
+
+	// the allocation tree is unchanged, so this checkpoint shares it with the previous one
+	model_allocator_checkpoint_take(mm, 1);
+
+	for(unsigned i = 0; i < cnt; ++i) {
+		for(unsigned j = 0; allocations[i] && j < words; ++j)
+			allocations[i][j] = 0;
+		__write_mem(allocations[i], allocations[i] ? 1 << B_BLOCK_EXP : 0);
+	}
+
+	model_allocator_checkpoint_restore(mm, 1);
+	b_rng = b_chk;
+
+	for(unsigned i = 0; i < cnt; ++i)
+		for(unsigned j = 0; allocations[i] && j < words; ++j)
+			errs += allocations[i][j] != rng_random_u(&b_rng);
+
+	for(unsigned i = 0; i < cnt; ++i)
+		rs_free(allocations[i]);
+
+	model_allocator_checkpoint_restore(mm, 0);
+	rng_init(&b_rng, BUDDY_TEST_SEED);
+
+	for(unsigned i = 0; i < cnt; ++i)
+		for(unsigned j = 0; allocations[i] && j < words; ++j)
+			errs += allocations[i][j] != rng_random_u(&b_rng);
+
+	for(unsigned i = 0; i < cnt; ++i)
+		rs_free(allocations[i]);
+
+	free(allocations);
+	return errs > 0;
+}
+
+static int compact_test(struct mm_state *mm)
+{
+	int errs = 0;
+	// small enough to be packed in the compact chunk of the LP
+	unsigned cnt = 8, words = 12;
+	test_rng_state b_rng, b_chk;
+	rng_init(&b_rng, BUDDY_TEST_SEED);
+	uint64_t *allocations[8];
+
+	for(unsigned i = 0; i < cnt; ++i) {
+		allocations[i] = rs_malloc(words * sizeof(uint64_t));
+		for(unsigned j = 0; j < words; ++j)
+			allocations[i][j] = rng_random_u(&b_rng);
+		__write_mem(allocations[i], words * sizeof(uint64_t));
+	}
+
+	// the allocations are contiguous, without any per-buddy overhead
+	for(unsigned i = 1; i < cnt; ++i)
+		errs += (unsigned char *)allocations[i] - (unsigned char *)allocations[i - 1] != 96;
+
+	// the freed granules are reused
+	void *p = allocations[3];
+	rs_free(allocations[3]);
+	allocations[3] = rs_malloc(words * sizeof(uint64_t));
+	errs += allocations[3] != p;
+	rs_free(allocations[3]);
+	allocations[3] = NULL;
+
+	model_allocator_checkpoint_take(mm, 0);
+	b_chk = b_rng;
+
+	for(unsigned i = 0; i < cnt; ++i) {
+		for(unsigned j = 0; allocations[i] && j < words; ++j)
+			allocations[i][j] = rng_random_u(&b_rng);
+		__write_mem(allocations[i], allocations[i] ? words * sizeof(uint64_t) : 0);
+	}
+
+	model_allocator_checkpoint_take(mm, 1);
+
+	// this doesn't fit in the compact chunk anymore, so the LP gets promoted
+	uint64_t *big = rs_malloc(1024);
+	errs += big == NULL;
+	errs += (unsigned char *)big >= (unsigned char *)allocations[0] &&
+		(unsigned char *)big < (unsigned char *)allocations[0] + 1024;
+	rs_free(allocations[0]);
+	errs += rs_realloc(allocations[1], 8) != allocations[1];
+
+	model_allocator_checkpoint_restore(mm, 1);
+	b_rng = b_chk;
+
+	for(unsigned i = 0; i < cnt; ++i)
+		for(unsigned j = 0; allocations[i] && j < words; ++j)
+			errs += allocations[i][j] != rng_random_u(&b_rng);
+
+	model_allocator_checkpoint_restore(mm, 0);
+	rng_init(&b_rng, BUDDY_TEST_SEED);
+
+	for(unsigned i = 0; i < cnt; ++i) {
+		for(unsigned j = 0; j < words; ++j) {
+			uint64_t r = rng_random_u(&b_rng);
+			errs += allocations[i] && allocations[i][j] != r;
+		}
+	}
+
+	return errs > 0;
+}
+
+static int reclaim_test(struct mm_state *mm)
+{
+	int errs = 0;
+	void *allocations[3];
+
+	for(unsigned i = 0; i < 3; ++i)
+		allocations[i] = rs_malloc(1 << B_TOTAL_EXP);
+
+	errs += array_count(mm->buddies) != 3;
+	model_allocator_checkpoint_take(mm, 0);
+
+	for(unsigned i = 0; i < 3; ++i)
+		rs_free(allocations[i]);
+
+	uint_fast32_t size = mm->full_ckpt_size;
+	model_allocator_checkpoint_take(mm, 1);
+
+	// the first checkpoint still references the buddy systems
+	errs += model_allocator_fossil_lp_collect(mm, 0) != 0;
+	errs += array_count(mm->buddies) != 3;
+
+	// the empty buddy systems are released once the first checkpoint is discarded
+	errs += model_allocator_fossil_lp_collect(mm, 1) != 1;
+	errs += array_count(mm->buddies) != 0;
+	errs += mm->full_ckpt_size >= size;
+
+	// and they are reused by later allocations
+	void *mem = rs_malloc(1 << B_TOTAL_EXP);
+	errs += mem != allocations[0];
+	errs += array_count(mm->buddies) != 1;
+
+	model_allocator_checkpoint_restore(mm, 0);
+	errs += array_count(mm->buddies) != 1;
+	mem = rs_malloc(1 << B_TOTAL_EXP);
+	errs += mem != allocations[0];
+
+	return errs > 0;
+}
+
+static int dedup_test(struct mm_state *mm)
+{
+	int errs = 0;
+	uint64_t *big[4], *small[8];
+	uint64_t hits = stats_retrieve(STATS_CKPT_DEDUP_HITS);
+
+	// identical content in different blocks and across checkpoints
+	for(unsigned i = 0; i < 4; ++i) {
+		big[i] = rs_malloc(1 << 13);
+		for(unsigned j = 0; j < (1 << 13) / sizeof(uint64_t); ++j)
+			big[i][j] = j;
+		__write_mem(big[i], 1 << 13);
+	}
+	for(unsigned i = 0; i < 8; ++i) {
+		small[i] = rs_malloc(200);
+		for(unsigned j = 0; j < 200 / sizeof(uint64_t); ++j)
+			small[i][j] = i * j;
+		__write_mem(small[i], 200);
+	}
+
+	model_allocator_checkpoint_take(mm, 0);
+	big[1][100] = 1;
+	__write_mem(&big[1][100], sizeof(uint64_t));
+	small[3][5] = 1;
+	__write_mem(&small[3][5], sizeof(uint64_t));
+	model_allocator_checkpoint_take(mm, 1);
+	big[2][200] = 2;
+	__write_mem(&big[2][200], sizeof(uint64_t));
+	small[4][6] = 2;
+	__write_mem(&small[4][6], sizeof(uint64_t));
+
+	model_allocator_checkpoint_restore(mm, 1);
+	errs += big[1][100] != 1 || big[2][200] != 200 || small[3][5] != 1 || small[4][6] != 24;
+
+	model_allocator_checkpoint_restore(mm, 0);
+	for(unsigned i = 0; i < 4; ++i)
+		for(unsigned j = 0; j < (1 << 13) / sizeof(uint64_t); ++j)
+			errs += big[i][j] != j;
+	for(unsigned i = 0; i < 8; ++i)
+		for(unsigned j = 0; j < 200 / sizeof(uint64_t); ++j)
+			errs += small[i][j] != i * j;
+
+#ifdef ROOTSIM_CKPT_DEDUP
+	errs += stats_retrieve(STATS_CKPT_DEDUP_HITS) == hits;
+#else
+	errs += stats_retrieve(STATS_CKPT_DEDUP_HITS) != hits;
+#endif
+	return errs > 0;
+}
+
+static int paging_test(struct lp_ctx *lp)
+{
+	int errs = 0;
+	struct mm_state *mm = &lp_cold(lp)->mm_state;
+	uint64_t *mem[6];
+	uint64_t outs = stats_retrieve(STATS_LP_PAGE_OUT), ins = stats_retrieve(STATS_LP_PAGE_IN);
+
+	for(unsigned i = 0; i < 6; ++i) {
+		mem[i] = rs_malloc(1 << (B_TOTAL_EXP - 1));
+		for(unsigned j = 0; j < (1 << (B_TOTAL_EXP - 1)) / sizeof(uint64_t); ++j)
+			mem[i][j] = i + j;
+		__write_mem(mem[i], 1 << (B_TOTAL_EXP - 1));
+	}
+	model_allocator_checkpoint_take(mm, 0);
+	mem[2][10] = 0;
+	__write_mem(&mem[2][10], sizeof(uint64_t));
+	model_allocator_checkpoint_take(mm, 1);
+
+	for(unsigned k = 0; k < 3; ++k) {
+		paging_lp_out(lp);
+		errs += !lp_cold(lp)->paged;
+		paging_lp_ensure(lp);
+		errs += lp_cold(lp)->paged;
+	}
+
+	errs += mem[2][10] != 0;
+	mem[2][10] = 1;
+	__write_mem(&mem[2][10], sizeof(uint64_t));
+	model_allocator_checkpoint_restore(mm, 1);
+	errs += mem[2][10] != 0;
+
+	paging_lp_out(lp);
+	paging_lp_in(lp);
+	model_allocator_checkpoint_restore(mm, 0);
+	for(unsigned i = 0; i < 6; ++i)
+		for(unsigned j = 0; j < (1 << (B_TOTAL_EXP - 1)) / sizeof(uint64_t); ++j)
+			errs += mem[i][j] != i + j;
+
+	errs += stats_retrieve(STATS_LP_PAGE_OUT) != outs + 4 || stats_retrieve(STATS_LP_PAGE_IN) != ins + 4;
+	paging_fini();
+	return errs > 0;
+}
+
+static int many_buddies_test(struct mm_state *mm)
+{
+	int errs = 0;
+	// enough buddy systems to fill several arena ranges when these are small
+	unsigned cnt = 300, words = (1 << B_TOTAL_EXP) / sizeof(uint64_t);
+	uint64_t **allocations = malloc(cnt * sizeof(uint64_t *));
+
+	for(unsigned i = 0; i < cnt; ++i) {
+		allocations[i] = rs_malloc(1 << B_TOTAL_EXP);
+		for(unsigned j = 0; j < words; ++j)
+			allocations[i][j] = (uint64_t)i * words + j;
+		__write_mem(allocations[i], 1 << B_TOTAL_EXP);
+	}
+	errs += array_count(mm->buddies) != cnt;
+
+	model_allocator_checkpoint_take(mm, 0);
+
+	for(unsigned i = 0; i < cnt; ++i) {
+		allocations[i][i] = 0;
+		__write_mem(&allocations[i][i], sizeof(uint64_t));
+		if(i % 3 == 0) {
+			rs_free(allocations[i]);
+		} else {
+			// the shrunk allocation stays in its buddy system
+			errs += rs_realloc(allocations[i], 1 << B_BLOCK_EXP) != allocations[i];
+		}
+	}
+
+	model_allocator_checkpoint_take(mm, 1);
+	model_allocator_checkpoint_restore(mm, 0);
+
+	for(unsigned i = 0; i < cnt; ++i) {
+		for(unsigned j = 0; j < words; ++j)
+			errs += allocations[i][j] != (uint64_t)i * words + j;
+		rs_free(allocations[i]);
+	}
+
+	free(allocations);
+	return errs > 0;
+}
+
 int model_allocator_test(_unused void *_)
 {
 	int errs = 0;
 
 	struct lp_ctx *lp = test_lp_mock_get();
 	current_lp = lp;
-	model_allocator_lp_init(&lp->mm_state);
+	model_allocator_lp_init(&lp_cold(lp)->mm_state);
+
+	errs += compact_test(&lp_cold(lp)->mm_state);
 
 	for(unsigned j = B_BLOCK_EXP; j < B_TOTAL_EXP; ++j)
-		errs += block_size_test(&lp->mm_state, j);
+		errs += block_size_test(&lp_cold(lp)->mm_state, j);
+
+	errs += realloc_test(&lp_cold(lp)->mm_state);
+	errs += fragmented_test(&lp_cold(lp)->mm_state);
 
 	errs += rs_malloc(0) != NULL;
 	errs += rs_calloc(0, sizeof(uint64_t)) != NULL;
@@ -109,7 +465,25 @@ int model_allocator_test(_unused void *_)
 	errs += *mem != 0;
 	rs_free(mem);
 
-	model_allocator_lp_fini(&lp->mm_state);
+	model_allocator_lp_fini(&lp_cold(lp)->mm_state);
+
+	model_allocator_lp_init(&lp_cold(lp)->mm_state);
+	errs += reclaim_test(&lp_cold(lp)->mm_state);
+	model_allocator_lp_fini(&lp_cold(lp)->mm_state);
+
+	model_allocator_lp_init(&lp_cold(lp)->mm_state);
+	errs += dedup_test(&lp_cold(lp)->mm_state);
+	model_allocator_lp_fini(&lp_cold(lp)->mm_state);
+
+	model_allocator_lp_init(&lp_cold(lp)->mm_state);
+	errs += many_buddies_test(&lp_cold(lp)->mm_state);
+	model_allocator_lp_fini(&lp_cold(lp)->mm_state);
+
+	global_config.paging_dir = ".";
+	model_allocator_lp_init(&lp_cold(lp)->mm_state);
+	errs += paging_test(lp);
+	model_allocator_lp_fini(&lp_cold(lp)->mm_state);
+	global_config.paging_dir = NULL;
 
 	return errs;
 }
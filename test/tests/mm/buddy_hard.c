@@ -46,7 +46,7 @@ static void allocation_init(struct alc *alc)
 		abort();
 	}
 	alc->c = c;
-	//	__write_mem(alc->ptr, alc->c * sizeof(unsigned));
+	__write_mem(alc->ptr, alc->c * sizeof(unsigned));
 
 	while(c--) {
 		unsigned v = test_random_u();
@@ -95,7 +95,7 @@ static void allocation_partial_write(struct alc *alc, unsigned p)
 		unsigned e = test_random_range(c + 1);
 		unsigned l = test_random_range(e + 1);
 
-		//		__write_mem(alc[i].ptr + l, (e - l) * sizeof(unsigned));
+		__write_mem(alc[i].ptr + l, (e - l) * sizeof(unsigned));
 
 		for(unsigned j = l; j < e; ++j) {
 			unsigned v = test_random_u();
@@ -174,12 +174,12 @@ int model_allocator_test_hard(_unused void *_)
 {
 	struct lp_ctx *lp = test_lp_mock_get();
 	current_lp = lp;
-	model_allocator_lp_init(&lp->mm_state);
+	model_allocator_lp_init(&lp_cold(lp)->mm_state);
 
 	struct alc *alc = allocation_all_init();
 
-	model_allocator_checkpoint_next_force_full(&lp->mm_state);
-	model_allocator_checkpoint_take(&lp->mm_state, 0);
+	model_allocator_checkpoint_next_force_full(&lp_cold(lp)->mm_state);
+	model_allocator_checkpoint_take(&lp_cold(lp)->mm_state, 0);
 
 	if(allocation_check(alc, 0)) {
 		return -1;
@@ -190,17 +190,17 @@ int model_allocator_test_hard(_unused void *_)
 		unsigned u = test_random_range(MAX_ALLOC_PHASES - 1) + 1;
 		unsigned d = test_random_range(u);
 
-		if(allocation_cycle(&lp->mm_state, alc, c, u, d)) {
+		if(allocation_cycle(&lp_cold(lp)->mm_state, alc, c, u, d)) {
 			return -1;
 		}
 
 		c = d;
 	}
 
-	model_allocator_checkpoint_restore(&lp->mm_state, 0);
+	model_allocator_checkpoint_restore(&lp_cold(lp)->mm_state, 0);
 
 	allocation_all_fini(alc);
-	model_allocator_lp_fini(&lp->mm_state);
+	model_allocator_lp_fini(&lp_cold(lp)->mm_state);
 
 	return 0;
 }
@@ -0,0 +1,150 @@
+/**
+ * @file test/tests/mm/bump.c
+ *
+ * @brief Test: append-only memory arena
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <test.h>
+
+#include <core/core.h>
+#include <log/log.h>
+#include <lp/lp.h>
+#include <mm/model_allocator.h>
+
+#define RECORDS_MAX 4096U
+#define CKPTS_CNT 6U
+
+/// A record appended to the arena
+struct record {
+	unsigned char *ptr;
+	unsigned size;
+	unsigned char val;
+};
+
+static struct record records[RECORDS_MAX];
+static unsigned records_cnt;
+
+/// The state of the records at the moment of each checkpoint
+static struct {
+	unsigned cnt;
+	unsigned char vals[RECORDS_MAX];
+} snapshots[CKPTS_CNT];
+
+static void records_append(unsigned cnt, unsigned size_max)
+{
+	while(cnt--) {
+		struct record *r = &records[records_cnt++];
+		r->size = test_random_range(size_max) + 1;
+		r->ptr = rs_bump_alloc(r->size);
+		r->val = test_random_range(256);
+		memset(r->ptr, r->val, r->size);
+	}
+}
+
+static void records_modify(unsigned cnt)
+{
+	while(cnt--) {
+		struct record *r = &records[test_random_range(records_cnt)];
+		rs_bump_touch(r->ptr, r->size);
+		r->val = test_random_range(256);
+		memset(r->ptr, r->val, r->size);
+	}
+}
+
+static void checkpoint_take(struct mm_state *mm, unsigned i)
+{
+	model_allocator_checkpoint_take(mm, i);
+	snapshots[i].cnt = records_cnt;
+	for(unsigned j = 0; j < records_cnt; ++j)
+		snapshots[i].vals[j] = records[j].val;
+}
+
+static int checkpoint_check(struct mm_state *mm, unsigned i)
+{
+	int errs = 0;
+	model_allocator_checkpoint_restore(mm, i);
+	records_cnt = snapshots[i].cnt;
+	for(unsigned j = 0; j < records_cnt; ++j) {
+		records[j].val = snapshots[i].vals[j];
+		for(unsigned k = 0; k < records[j].size; ++k)
+			errs += records[j].ptr[k] != records[j].val;
+	}
+	return errs;
+}
+
+static int bump_test(_unused void *_)
+{
+	int errs = 0;
+
+	struct lp_ctx *lp = test_lp_mock_get();
+	current_lp = lp;
+	model_allocator_lp_init(&lp_cold(lp)->mm_state);
+	struct mm_state *mm = &lp_cold(lp)->mm_state;
+
+	errs += rs_bump_alloc(0) != NULL;
+
+	checkpoint_take(mm, 0);
+	errs += array_get_at(mm->logs, 0).c->bump != NULL;
+
+	records_append(100, 64);
+	checkpoint_take(mm, 1);
+
+	records_append(200, 300);
+	records_modify(5);
+	checkpoint_take(mm, 2);
+	errs += array_peek(mm->logs).c->bump->undo_size == 0;
+
+	// pure appends only need the end of the arena to move back
+	array_count_t chunks = array_count(mm->bump.chunks);
+	unsigned char *end = array_peek(mm->bump.chunks).mem + array_peek(mm->bump.chunks).used;
+	records_append(300, 2000);
+	checkpoint_take(mm, 3);
+	errs += array_peek(mm->logs).c->bump->undo_size != 0;
+	records_modify(20);
+	records_append(10, 100);
+	errs += checkpoint_check(mm, 3);
+
+	errs += checkpoint_check(mm, 2);
+	errs += array_count(mm->bump.chunks) != chunks;
+	errs += array_peek(mm->bump.chunks).mem + array_peek(mm->bump.chunks).used != end;
+
+	records_modify(30);
+	records_append(500, 1000);
+	checkpoint_take(mm, 3);
+	records_modify(10);
+	checkpoint_take(mm, 4);
+	records_modify(10);
+	records_append(10, 100);
+	errs += checkpoint_check(mm, 2);
+
+	records_modify(10);
+	checkpoint_take(mm, 3);
+	records_modify(10);
+	records_append(20, 100);
+	checkpoint_take(mm, 4);
+	records_modify(10);
+
+	// after fossil collection, the retained checkpoints must not need the collected ones
+	errs += model_allocator_fossil_lp_collect(mm, 3) != 3;
+	errs += array_get_at(mm->logs, 0).c->bump->undo_size != 0;
+	snapshots[0] = snapshots[3];
+	snapshots[1] = snapshots[4];
+	errs += checkpoint_check(mm, 1);
+	records_modify(10);
+	errs += checkpoint_check(mm, 0);
+
+	model_allocator_checkpoint_restore(mm, 0);
+	errs += checkpoint_check(mm, 0);
+
+	model_allocator_lp_fini(mm);
+	return errs;
+}
+
+int main(void)
+{
+	log_init(stdout);
+
+	test("Testing append-only arena", bump_test, NULL);
+}
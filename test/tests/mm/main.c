@@ -10,17 +10,43 @@
  */
 #include <test.h>
 
+#include <core/core.h>
 #include <log/log.h>
 
 extern int model_allocator_test(void *);
 extern int model_allocator_test_hard(void *);
 extern int parallel_malloc_test(void *);
 
+#ifndef ROOTSIM_SLAB_ALLOCATOR
+static int huge_pages_test(void *arg)
+{
+	global_config.huge_pages = true;
+	int ret = model_allocator_test(arg);
+	global_config.huge_pages = false;
+	return ret;
+}
+
+static int write_tracking_test(void *arg)
+{
+	global_config.write_tracking = true;
+	int ret = model_allocator_test(arg) + model_allocator_test_hard(arg);
+	global_config.write_tracking = false;
+	return ret;
+}
+#endif
+
 int main(void)
 {
 	log_init(stdout);
 
+#ifdef ROOTSIM_SLAB_ALLOCATOR
+	test("Testing slab allocator", model_allocator_test, NULL);
+	test("Testing slab allocator (hard test)", model_allocator_test_hard, NULL);
+#else
 	test("Testing buddy system", model_allocator_test, NULL);
 	test("Testing buddy system (hard test)", model_allocator_test_hard, NULL);
 	test("Testing parallel memory operations", parallel_malloc_test, NULL);
+	test("Testing buddy system with huge pages", huge_pages_test, NULL);
+	test("Testing buddy system with write tracking", write_tracking_test, NULL);
+#endif
 }
@@ -0,0 +1,205 @@
+/**
+ * @file test/tests/mm/msg_allocator.c
+ *
+ * @brief Test: message allocator recycling across threads
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <test.h>
+
+#include <core/core.h>
+#include <core/sync.h>
+#include <log/stats.h>
+#include <mm/msg_allocator.h>
+
+#include <string.h>
+
+#define THREADS_CNT 4U
+#define MSGS_CNT 1000U
+
+static struct lp_msg *msgs[THREADS_CNT][MSGS_CNT];
+static unsigned sizes[MSGS_CNT];
+
+static int msg_owner_test(_unused void *_)
+{
+	int errs = 0;
+	rid = test_parallel_thread_id();
+	msg_allocator_init();
+
+	for(unsigned i = 0; i < MSGS_CNT; ++i) {
+		msgs[rid][i] = msg_allocator_alloc(test_random_range(MSG_PAYLOAD_BASE_SIZE + 1));
+		errs += msgs[rid][i]->owner != rid;
+	}
+	sync_thread_barrier();
+
+	// release the messages allocated by another thread, which must find their way back to it
+	for(unsigned i = 0; i < MSGS_CNT; ++i)
+		msg_allocator_free(msgs[(rid + 1) % THREADS_CNT][i]);
+	errs += stats_retrieve(STATS_MSG_RETURNED) > MSGS_CNT;
+	msg_allocator_on_gvt(0.0);
+	errs += stats_retrieve(STATS_MSG_RETURNED) != MSGS_CNT;
+	sync_thread_barrier();
+
+	uint64_t misses = stats_retrieve(STATS_MSG_POOL_MISS);
+	for(unsigned i = 0; i < MSGS_CNT; ++i) {
+		struct lp_msg *msg = msg_allocator_alloc(MSG_PAYLOAD_BASE_SIZE);
+		errs += msg->owner != rid;
+		msg_allocator_free(msg);
+	}
+	errs += stats_retrieve(STATS_MSG_POOL_MISS) != misses;
+	errs += stats_retrieve(STATS_MSG_RECLAIMED) != MSGS_CNT;
+
+	sync_thread_barrier();
+	msg_allocator_fini();
+	return errs;
+}
+
+static int msg_size_class_test(_unused void *_)
+{
+	int errs = 0;
+	rid = 0;
+	msg_allocator_init();
+
+	unsigned max = MSG_PAYLOAD_BASE_SIZE << (MSG_SIZE_CLASSES - 1);
+	for(unsigned i = 0; i < MSGS_CNT; ++i) {
+		sizes[i] = test_random_range(max + 1);
+		msgs[0][i] = msg_allocator_alloc(sizes[i]);
+		memset(msgs[0][i]->pl, i, sizes[i]);
+	}
+	for(unsigned i = 0; i < MSGS_CNT; ++i)
+		msg_allocator_free(msgs[0][i]);
+
+	// the same sizes must now be served by the pools
+	uint64_t misses = 0;
+	for(unsigned c = 0; c < MSG_SIZE_CLASSES; ++c)
+		misses += stats_retrieve(STATS_MSG_POOL_MISS + c);
+	errs += misses != MSGS_CNT;
+
+	for(unsigned i = 0; i < MSGS_CNT; ++i) {
+		msgs[0][i] = msg_allocator_alloc(sizes[i]);
+		memset(msgs[0][i]->pl, i, sizes[i]);
+	}
+	uint64_t hits = 0;
+	for(unsigned c = 0; c < MSG_SIZE_CLASSES; ++c)
+		hits += stats_retrieve(STATS_MSG_POOL_HIT + c);
+	errs += hits != MSGS_CNT;
+
+	struct lp_msg *msg = msg_allocator_alloc(max + 1);
+	memset(msg->pl, 0, max + 1);
+	errs += stats_retrieve(STATS_MSG_UNPOOLED) != 1;
+	msg_allocator_free(msg);
+
+	for(unsigned i = 0; i < MSGS_CNT; ++i)
+		msg_allocator_free(msgs[0][i]);
+
+	msg_allocator_fini();
+	return errs;
+}
+
+static int msg_at_gvt_test(_unused void *_)
+{
+	int errs = 0;
+	rid = 0;
+	msg_allocator_init();
+
+	unsigned committed = 0;
+	for(unsigned i = 0; i < MSGS_CNT; ++i) {
+		struct lp_msg *msg = msg_allocator_alloc(0);
+		msg->dest_t = test_random_double() * 100.0;
+		committed += msg->dest_t < 50.0;
+		msg_allocator_free_at_gvt(msg);
+	}
+
+	uint64_t hits = stats_retrieve(STATS_MSG_POOL_HIT);
+	msg_allocator_on_gvt(50.0);
+	for(unsigned i = 0; i < MSGS_CNT; ++i)
+		msg_allocator_at_gvt_collect();
+
+	// exactly the committed messages must have been released in the pool
+	for(unsigned i = 0; i < committed; ++i)
+		msgs[0][i] = msg_allocator_alloc(0);
+	errs += stats_retrieve(STATS_MSG_POOL_HIT) - hits != committed;
+	msgs[0][committed] = msg_allocator_alloc(0);
+	errs += stats_retrieve(STATS_MSG_POOL_HIT) - hits != committed;
+
+	for(unsigned i = 0; i <= committed; ++i)
+		msg_allocator_free(msgs[0][i]);
+
+	msg_allocator_fini();
+	return errs;
+}
+
+static uint64_t misses_count(void)
+{
+	uint64_t ret = 0;
+	for(unsigned c = 0; c < MSG_SIZE_CLASSES; ++c)
+		ret += stats_retrieve(STATS_MSG_POOL_MISS + c);
+	return ret;
+}
+
+static int msg_arena_test(_unused void *_)
+{
+	int errs = 0;
+	rid = 0;
+	global_config.msg_pool_size = 30 * MSGS_CNT;
+	global_config.msg_pool_calibrate = true;
+	msg_allocator_init();
+
+	uint64_t misses = misses_count();
+	struct lp_msg *head = NULL;
+	for(unsigned i = 0; i < global_config.msg_pool_size; ++i) {
+		struct lp_msg *msg = msg_allocator_alloc(MSG_PAYLOAD_BASE_SIZE);
+		memset(msg->pl, i, MSG_PAYLOAD_BASE_SIZE);
+		msg->next = head;
+		head = msg;
+	}
+	errs += misses_count() != misses;
+
+	// larger size classes grow in whole chunks
+	for(unsigned i = 0; i < MSGS_CNT; ++i) {
+		msgs[0][i] = msg_allocator_alloc(MSG_PAYLOAD_BASE_SIZE * 3);
+		memset(msgs[0][i]->pl, i, MSG_PAYLOAD_BASE_SIZE * 3);
+	}
+	errs += misses_count() != misses + 1;
+
+	while(head != NULL) {
+		struct lp_msg *next = head->next;
+		msg_allocator_free(head);
+		head = next;
+	}
+	for(unsigned i = 0; i < MSGS_CNT; ++i)
+		msg_allocator_free(msgs[0][i]);
+
+	// the calibration enlarges the pools according to the messages carved so far
+	msg_allocator_on_gvt(1.0);
+	misses = misses_count();
+	for(unsigned i = 0; i < 3 * global_config.msg_pool_size; ++i) {
+		struct lp_msg *msg = msg_allocator_alloc(0);
+		msg->next = head;
+		head = msg;
+	}
+	errs += misses_count() != misses;
+
+	while(head != NULL) {
+		struct lp_msg *next = head->next;
+		msg_allocator_free(head);
+		head = next;
+	}
+
+	msg_allocator_fini();
+	global_config.msg_pool_size = 0;
+	global_config.msg_pool_calibrate = false;
+	return errs;
+}
+
+int main(void)
+{
+	global_config.n_threads = THREADS_CNT;
+	msg_allocator_global_init();
+	test_parallel("Testing message recycling across threads", msg_owner_test, NULL, THREADS_CNT);
+	test("Testing message size classes", msg_size_class_test, NULL);
+	test("Testing messages freed at GVT", msg_at_gvt_test, NULL);
+	test("Testing pre-allocated message arena", msg_arena_test, NULL);
+	msg_allocator_global_fini();
+}
@@ -145,7 +145,7 @@ int parallel_malloc_test(_unused void *_)
 
 	struct lp_ctx *lp = test_lp_mock_get();
 	current_lp = lp;
-	model_allocator_lp_init(&lp->mm_state);
+	model_allocator_lp_init(&lp_cold(lp)->mm_state);
 
 	struct bin_info p;
 	p.size = (1 << (B_BLOCK_EXP + 1));
@@ -186,7 +186,7 @@ int parallel_malloc_test(_unused void *_)
 
 	free(p.m);
 
-	model_allocator_lp_fini(&lp->mm_state);
+	model_allocator_lp_fini(&lp_cold(lp)->mm_state);
 
 	return 0;
 }
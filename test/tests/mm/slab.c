@@ -0,0 +1,102 @@
+/**
+ * @file test/tests/mm/slab.c
+ *
+ * @brief Test: rollbackable size-class slab allocator
+ *
+ * A test of the slab allocator used to handle model's memory
+ *
+ * SPDX-FileCopyrightText: 2008-2022 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <test.h>
+
+#include <lp/lp.h>
+#include <mm/model_allocator.h>
+#include <mm/slab/slab.h>
+
+#define SLAB_TEST_ALLOCS 1024
+
+static int size_class_test(void)
+{
+	int errs = 0;
+
+	errs += slab_class_size(slab_class_compute(72)) != 80;
+	errs += slab_class_size(slab_class_compute(136)) != 160;
+
+	unsigned prev = 0;
+	for(size_t s = 1; s <= SLAB_HUGE_SIZE; ++s) {
+		unsigned c = slab_class_compute(s);
+		errs += c < prev || c >= SLAB_CLASSES;
+		errs += slab_class_size(c) < s;
+		errs += c && slab_class_size(c - 1) >= s;
+		prev = c;
+	}
+
+	return errs;
+}
+
+static int checkpoint_test(struct mm_state *mm)
+{
+	int errs = 0;
+	unsigned *allocs[SLAB_TEST_ALLOCS];
+
+	for(unsigned i = 0; i < SLAB_TEST_ALLOCS; ++i) {
+		allocs[i] = rs_malloc((i % 64 + 1) * sizeof(unsigned));
+		for(unsigned j = 0; j <= i % 64; ++j)
+			allocs[i][j] = i ^ j;
+	}
+
+	model_allocator_checkpoint_take(mm, 0);
+
+	for(unsigned i = 0; i < SLAB_TEST_ALLOCS; i += 2)
+		rs_free(allocs[i]);
+
+	// these land both in freed objects and in new slabs
+	for(unsigned i = 0; i < SLAB_TEST_ALLOCS; ++i)
+		memset(rs_malloc(SLAB_HUGE_SIZE / (i % 8 + 1)), 0xff, SLAB_HUGE_SIZE / (i % 8 + 1));
+
+	for(unsigned i = 1; i < SLAB_TEST_ALLOCS; i += 2)
+		allocs[i][0] = 0;
+
+	model_allocator_checkpoint_take(mm, 1);
+	model_allocator_checkpoint_restore(mm, 0);
+
+	for(unsigned i = 0; i < SLAB_TEST_ALLOCS; ++i)
+		for(unsigned j = 0; j <= i % 64; ++j)
+			errs += allocs[i][j] != (i ^ j);
+
+	// after the restore, freed objects must be handed out again without overlapping live ones
+	unsigned *n = rs_malloc(sizeof(unsigned));
+	for(unsigned i = 0; i < SLAB_TEST_ALLOCS; ++i)
+		errs += n == allocs[i];
+	rs_free(n);
+
+	for(unsigned i = 0; i < SLAB_TEST_ALLOCS; ++i)
+		rs_free(allocs[i]);
+
+	return errs;
+}
+
+int model_allocator_test(_unused void *_)
+{
+	int errs = size_class_test();
+
+	struct lp_ctx *lp = test_lp_mock_get();
+	current_lp = lp;
+	model_allocator_lp_init(&lp_cold(lp)->mm_state);
+
+	errs += checkpoint_test(&lp_cold(lp)->mm_state);
+
+	errs += rs_malloc(0) != NULL;
+	errs += rs_malloc(SLAB_HUGE_SIZE + 1) != NULL;
+
+	unsigned *mem = rs_malloc(72);
+	errs += rs_realloc(mem, 80) != mem;
+	mem = rs_realloc(mem, 136);
+	errs += mem == NULL;
+	rs_free(mem);
+
+	model_allocator_lp_fini(&lp_cold(lp)->mm_state);
+
+	return errs;
+}